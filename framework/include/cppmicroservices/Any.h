@@ -39,8 +39,11 @@ DEALINGS IN THE SOFTWARE.
 #include <list>
 #include <map>
 #include <memory>
+#include <new>
 #include <set>
 #include <sstream>
+#include <string>
+#include <type_traits>
 #include <typeinfo>
 #include <utility>
 #include <vector>
@@ -177,6 +180,12 @@ std::ostream& any_value_to_json(std::ostream& os, const std::map<K, V>& m);
  * of the internally stored data.
  *
  * Code taken from the Boost 1.46.1 library. Original copyright by Kevlin Henney. Modified for CppMicroServices.
+ *
+ * Values of small types which can be moved without throwing, e.g. integral
+ * and floating point values, <code>bool</code> and <code>std::string</code>,
+ * are stored inside the Any object itself. Other values are allocated on
+ * the heap. The inline storage makes an Any larger than a pointer, which
+ * changed its size and layout in CppMicroServices 4.0.
  */
 class US_Framework_EXPORT Any
 {
@@ -199,7 +208,7 @@ public:
    */
   template<typename ValueType>
   Any(const ValueType& value)
-    : _content(new Holder<ValueType>(value))
+    : _content(Create(_storage, value))
   {}
 
   /**
@@ -208,7 +217,7 @@ public:
    * \param other The Any to copy
    */
   Any(const Any& other)
-    : _content(other._content ? other._content->Clone() : nullptr)
+    : _content(other._content ? other._content->Clone(_storage) : nullptr)
   {}
 
   /**
@@ -217,8 +226,12 @@ public:
    * @param other The Any to move
    */
   Any(Any&& other) noexcept
-    : _content(std::move(other._content))
-  {}
+    : _content(nullptr)
+  {
+    MoveFrom(other);
+  }
+
+  ~Any() { Reset(); }
 
   /**
    * Swaps the content of the two Anys.
@@ -227,7 +240,11 @@ public:
    */
   Any& Swap(Any& rhs)
   {
-    std::swap(_content, rhs._content);
+    if (this != &rhs) {
+      Any tmp(std::move(rhs));
+      rhs.MoveFrom(*this);
+      MoveFrom(tmp);
+    }
     return *this;
   }
 
@@ -301,7 +318,10 @@ public:
    */
   Any& operator=(Any&& rhs)
   {
-    _content = std::move(rhs._content);
+    if (this != &rhs) {
+      Reset();
+      MoveFrom(rhs);
+    }
     return *this;
   }
 
@@ -348,6 +368,14 @@ public:
   }
 
 private:
+  /**
+   * Inline storage, large enough for a Holder of a std::string or of a
+   * 16 byte value.
+   */
+  using Storage = std::aligned_storage<
+    sizeof(void*) + (sizeof(std::string) > 16 ? sizeof(std::string) : 16),
+    alignof(void*)>::type;
+
   class Placeholder
   {
   public:
@@ -357,9 +385,75 @@ private:
     virtual std::string ToJSON() const = 0;
 
     virtual const std::type_info& Type() const = 0;
-    virtual std::unique_ptr<Placeholder> Clone() const = 0;
+
+    //! Copy the held value into \c storage or onto the heap.
+    virtual Placeholder* Clone(Storage& storage) const = 0;
+
+    //! Move an inline placeholder into \c storage and destroy it.
+    virtual Placeholder* MoveTo(Storage& storage) noexcept = 0;
   };
 
+  template<typename ValueType>
+  class Holder;
+
+  template<typename ValueType>
+  struct IsInline
+    : std::integral_constant<
+        bool,
+        sizeof(Holder<ValueType>) <= sizeof(Storage) &&
+          alignof(Holder<ValueType>) <= alignof(Storage) &&
+          std::is_nothrow_move_constructible<ValueType>::value>
+  {};
+
+  template<typename ValueType>
+  static Placeholder* Create(Storage& storage, const ValueType& value)
+  {
+    return Create(storage, value, IsInline<ValueType>());
+  }
+
+  template<typename ValueType>
+  static Placeholder* Create(Storage& storage,
+                             const ValueType& value,
+                             std::true_type)
+  {
+    return new (&storage) Holder<ValueType>(value);
+  }
+
+  template<typename ValueType>
+  static Placeholder* Create(Storage&, const ValueType& value, std::false_type)
+  {
+    return new Holder<ValueType>(value);
+  }
+
+  bool IsInlineContent() const
+  {
+    return static_cast<const void*>(_content) >=
+             static_cast<const void*>(&_storage) &&
+           static_cast<const void*>(_content) <
+             static_cast<const void*>(&_storage + 1);
+  }
+
+  void Reset()
+  {
+    if (IsInlineContent()) {
+      _content->~Placeholder();
+    } else {
+      delete _content;
+    }
+    _content = nullptr;
+  }
+
+  // requires this Any to be empty
+  void MoveFrom(Any& other) noexcept
+  {
+    if (other.IsInlineContent()) {
+      _content = other._content->MoveTo(_storage);
+    } else {
+      _content = other._content;
+    }
+    other._content = nullptr;
+  }
+
   template<typename ValueType>
   class Holder : public Placeholder
   {
@@ -384,15 +478,30 @@ private:
 
     const std::type_info& Type() const override { return typeid(ValueType); }
 
-    std::unique_ptr<Placeholder> Clone() const override
+    Placeholder* Clone(Storage& storage) const override
+    {
+      return Create(storage, _held);
+    }
+
+    Placeholder* MoveTo(Storage& storage) noexcept override
     {
-      return std::unique_ptr<Placeholder>(new Holder(_held));
+      return MoveTo(storage, IsInline<ValueType>());
     }
 
     ValueType _held;
 
   private: // intentionally left unimplemented
     Holder& operator=(const Holder&) = delete;
+
+    Placeholder* MoveTo(Storage& storage, std::true_type) noexcept
+    {
+      Placeholder* moved = new (&storage) Holder(std::move(_held));
+      this->~Holder();
+      return moved;
+    }
+
+    // Values on the heap are moved by transferring the pointer
+    Placeholder* MoveTo(Storage&, std::false_type) noexcept { return this; }
   };
 
 private:
@@ -402,7 +511,8 @@ private:
   template<typename ValueType>
   friend ValueType* unsafe_any_cast(Any*);
 
-  std::unique_ptr<Placeholder> _content;
+  Storage _storage;
+  Placeholder* _content;
 };
 
 /**
@@ -465,8 +575,7 @@ template<typename ValueType>
 ValueType* any_cast(Any* operand)
 {
   return operand && operand->Type() == typeid(ValueType)
-           ? &static_cast<Any::Holder<ValueType>*>(operand->_content.get())
-                ->_held
+           ? &static_cast<Any::Holder<ValueType>*>(operand->_content)->_held
            : nullptr;
 }
 
@@ -600,7 +709,7 @@ ValueType& ref_any_cast(Any& operand)
 template<typename ValueType>
 ValueType* unsafe_any_cast(Any* operand)
 {
-  return &static_cast<Any::Holder<ValueType>*>(operand->_content.get())->_held;
+  return &static_cast<Any::Holder<ValueType>*>(operand->_content)->_held;
 }
 
 /**
@@ -1070,6 +1070,30 @@ public:
    */
   std::vector<Bundle> InstallBundles(const std::string& location);
 
+  /**
+   * Installs all bundles from the bundle libraries at the specified
+   * locations.
+   *
+   * This is equivalent to calling InstallBundles(const std::string&) for
+   * each location, but bundle libraries which are not installed yet are
+   * opened and their manifests are parsed concurrently. The new bundles
+   * are assigned identifiers and <code>BundleEvent::BUNDLE_INSTALLED</code>
+   * events are fired in the order of \c locations.
+   *
+   * If one of the bundle libraries which are not installed yet cannot be
+   * installed, none of them is installed.
+   *
+   * @param locations The locations of the bundle libraries to install.
+   * @return The Bundle objects of the installed bundle libraries, in the
+   *         order of \c locations.
+   * @throws std::runtime_error If the BundleContext is no longer valid, or if the installation failed.
+   * @throws std::logic_error If the framework instance is no longer active
+   * @throws std::invalid_argument If a location is not a valid UTF8 string
+   *
+   * @see InstallBundles(const std::string&)
+   */
+  std::vector<Bundle> InstallBundles(const std::vector<std::string>& locations);
+
 private:
   friend US_Framework_EXPORT BundleContext
   MakeBundleContext(BundleContextPrivate*);
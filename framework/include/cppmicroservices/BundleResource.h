@@ -25,6 +25,7 @@
 
 #include "cppmicroservices/FrameworkExport.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <ostream>
@@ -35,12 +36,71 @@ namespace cppmicroservices {
 class BundleResourcePrivate;
 struct BundleArchive;
 
+namespace detail {
+class BundleResourceBuffer;
+}
+
 /**
 \defgroup gr_bundleresource BundleResource
 
 \brief Groups BundleResource class related symbols.
 */
 
+/**
+ * \ingroup MicroServices
+ * \ingroup gr_bundleresource
+ *
+ * A read-only view of the uncompressed data of a BundleResource.
+ *
+ * If the resource is stored uncompressed in a memory mapped bundle, the
+ * view points directly into the mapping. Otherwise it owns a decompressed
+ * copy of the data. In both cases the data stays valid as long as a copy
+ * of the view exists, independent of the BundleResource and its bundle.
+ *
+ * %BundleResourceView objects have value semantics and copies are very
+ * inexpensive.
+ *
+ * @see BundleResource::GetView()
+ */
+class BundleResourceView
+{
+
+public:
+  using value_type = char;
+  using size_type = std::size_t;
+  using const_iterator = const char*;
+  using iterator = const_iterator;
+
+  /**
+   * Creates an empty view.
+   */
+  BundleResourceView()
+    : m_Size(0)
+  {}
+
+  /**
+   * Creates a view of \c size bytes starting at \c data. The shared
+   * pointer keeps the viewed memory alive.
+   */
+  BundleResourceView(std::shared_ptr<const char> data, size_type size)
+    : m_Data(std::move(data))
+    , m_Size(m_Data ? size : 0)
+  {}
+
+  const char* data() const noexcept { return m_Data.get(); }
+  size_type size() const noexcept { return m_Size; }
+  bool empty() const noexcept { return m_Size == 0; }
+
+  const_iterator begin() const noexcept { return data(); }
+  const_iterator end() const noexcept { return data() + m_Size; }
+
+  char operator[](size_type pos) const { return m_Data.get()[pos]; }
+
+private:
+  std::shared_ptr<const char> m_Data;
+  size_type m_Size;
+};
+
 /**
  * \ingroup MicroServices
  * \ingroup gr_bundleresource
@@ -296,6 +356,18 @@ public:
    */
   uint32_t GetCrc32() const;
 
+  /**
+   * Returns a view of the uncompressed resource data.
+   *
+   * Resources which are stored without compression in a memory mapped
+   * bundle are returned without copying them. For all other resources,
+   * the data is decompressed into a new buffer owned by the view.
+   *
+   * @return A view of the resource data, or an empty view if this object
+   * is invalid or the data could not be read.
+   */
+  BundleResourceView GetView() const;
+
 private:
   BundleResource(const std::string& file,
                  const std::shared_ptr<const BundleArchive>& archive);
@@ -306,12 +378,17 @@ private:
   friend struct BundleArchive;
   friend class BundleResourceContainer;
   friend class BundleResourceStream;
+  friend class detail::BundleResourceBuffer;
 
   friend struct ::std::hash<BundleResource>;
 
   std::size_t Hash() const;
 
-  std::unique_ptr<void, void (*)(void*)> GetData() const;
+  /**
+   * Returns a view of the raw deflate stream of a compressed resource in a
+   * memory mapped bundle, or an empty view if it is not available.
+   */
+  BundleResourceView GetDeflatedView() const;
 
   BundleResourcePrivate* d;
 };
@@ -39,6 +39,10 @@ class BundleResource;
  * This class provides access to the resource data embedded in a bundle's
  * shared library via a STL input stream interface.
  *
+ * Large compressed resources of memory mapped bundles are inflated
+ * incrementally while reading, using a fixed-size window. Seeking backwards
+ * in such a stream restarts the decompression.
+ *
  * \see BundleResource for an example how to use this class.
  */
 class US_Framework_EXPORT BundleResourceStream
@@ -159,6 +159,18 @@ US_Framework_EXPORT extern const std::string
 US_Framework_EXPORT extern const std::string
   BUNDLE_SYMBOLICNAME; // = "bundle.symbolic_name";
 
+/**
+ * Manifest header listing the symbolic names of bundles which must be
+ * started before this bundle when bundles are started as a batch.
+ *
+ * The header value may be retrieved from the \c AnyMap object
+ * returned by the \c Bundle::GetHeaders() method.
+ *
+ * @see Framework::StartBundles(const std::vector<Bundle>&, uint32_t)
+ */
+US_Framework_EXPORT extern const std::string
+  BUNDLE_REQUIRES; // = "bundle.requires";
+
 /**
  * Manifest header identifying the base name of the bundle's localization
  * entries.
@@ -263,6 +275,38 @@ US_Framework_EXPORT extern const std::string
 US_Framework_EXPORT extern const std::string
   FRAMEWORK_STORAGE_CLEAN_ONFIRSTINIT; // = "onFirstInit";
 
+/**
+ * Framework launching property specifying how the framework stores the
+ * installed bundles.
+ * This property's default value is "memory".
+ * Valid key values are:
+ * - "memory" - Installed bundles are forgotten when the framework is
+ *   initialized again.
+ * - "file" - Installed bundles, their autostart settings and manifests are
+ *   kept in the persistent storage area. They are restored when the
+ *   framework is initialized again and bundles which were started are
+ *   started when the framework starts.
+ *
+ * @see #FRAMEWORK_STORAGE
+ * @see #FRAMEWORK_STORAGE_CLEAN
+ */
+US_Framework_EXPORT extern const std::string
+  FRAMEWORK_STORAGE_TYPE; // = "org.cppmicroservices.framework.storage.type";
+
+/**
+ * Framework storage type declaring that installed bundles are only kept
+ * in memory.
+ */
+US_Framework_EXPORT extern const std::string
+  FRAMEWORK_STORAGE_TYPE_MEMORY; // = "memory";
+
+/**
+ * Framework storage type declaring that installed bundles are kept in
+ * the persistent storage area.
+ */
+US_Framework_EXPORT extern const std::string
+  FRAMEWORK_STORAGE_TYPE_FILE; // = "file";
+
 /**
  * The framework's threading support property key name.
  * This property's default value is "single".
@@ -309,6 +353,133 @@ US_Framework_EXPORT extern const std::string
 US_Framework_EXPORT extern const std::string
   FRAMEWORK_LOG; // = "org.cppmicroservices.framework.log";
 
+/**
+ * Framework launching property specifying the number of idle bundle
+ * threads the framework keeps alive for running bundle activators and
+ * synchronous bundle listeners. Additional threads are created on demand
+ * and terminate after being idle for a short time.
+ * This property's default value is the number of hardware threads (int).
+ *
+ * This property is ignored if the framework was built without threading
+ * support.
+ */
+US_Framework_EXPORT extern const std::string
+  FRAMEWORK_BUNDLE_THREADS; // = "org.cppmicroservices.framework.bundle.threads";
+
+/**
+ * Framework launching property specifying how bundle and service events
+ * are delivered to listeners.
+ * This property's default value is "sync".
+ * Valid key values are:
+ * - "sync" - Listeners are called on the thread which caused the event,
+ *   before the operation which caused the event returns.
+ * - "async" - Events are queued and listeners are called on framework
+ *   threads. The events for the listeners of a bundle are delivered in
+ *   the order in which they occurred.
+ *
+ * This property is ignored if the framework was built without threading
+ * support. Framework events are always delivered synchronously.
+ *
+ * @see #FRAMEWORK_EVENT_QUEUE_LIMIT
+ */
+US_Framework_EXPORT extern const std::string
+  FRAMEWORK_EVENT_DELIVERY; // = "org.cppmicroservices.framework.event.delivery";
+
+/**
+ * Framework event delivery configuration declaring that listeners are
+ * called synchronously.
+ */
+US_Framework_EXPORT extern const std::string
+  FRAMEWORK_EVENT_DELIVERY_SYNC; // = "sync";
+
+/**
+ * Framework event delivery configuration declaring that listeners are
+ * called asynchronously.
+ */
+US_Framework_EXPORT extern const std::string
+  FRAMEWORK_EVENT_DELIVERY_ASYNC; // = "async";
+
+/**
+ * Framework launching property specifying the maximum number of events
+ * queued for the listeners of a bundle with asynchronous event delivery.
+ * A thread causing an event for a full queue waits until the queue has
+ * room again, unless it is delivering events itself.
+ * This property's default value is 1024 (int). A value of zero means
+ * that the number of queued events is not limited.
+ *
+ * @see #FRAMEWORK_EVENT_DELIVERY
+ */
+US_Framework_EXPORT extern const std::string
+  FRAMEWORK_EVENT_QUEUE_LIMIT; // = "org.cppmicroservices.framework.event.queue.limit";
+
+/**
+ * Read-only framework property holding the number of events which are
+ * queued for asynchronous delivery (long).
+ *
+ * The value may be retrieved via the \c BundleContext::GetProperty method.
+ *
+ * @see #FRAMEWORK_EVENT_DELIVERY
+ */
+US_Framework_EXPORT extern const std::string
+  FRAMEWORK_EVENT_QUEUE_DEPTH; // = "org.cppmicroservices.framework.event.queue.depth";
+
+/**
+ * Read-only framework property holding the largest number of events
+ * which were queued for the listeners of a single bundle (long).
+ *
+ * The value may be retrieved via the \c BundleContext::GetProperty method.
+ *
+ * @see #FRAMEWORK_EVENT_DELIVERY
+ */
+US_Framework_EXPORT extern const std::string
+  FRAMEWORK_EVENT_QUEUE_MAX_DEPTH; // = "org.cppmicroservices.framework.event.queue.max_depth";
+
+/**
+ * Framework launching property specifying the number of bytes of
+ * decompressed resource data which are cached for all bundles. A
+ * resource which was decompressed for BundleResource::GetView or a
+ * BundleResourceStream is served from the cache when it is read again,
+ * and the least recently used resources are evicted when the cache is
+ * full. Uncompressed resources of memory mapped bundles are never cached.
+ * This property's default value is 4194304 (int). A value of zero
+ * disables the cache.
+ */
+US_Framework_EXPORT extern const std::string
+  FRAMEWORK_RESOURCE_CACHE_SIZE; // = "org.cppmicroservices.framework.resource.cache.size";
+
+/**
+ * Read-only framework property holding the number of resource reads which
+ * were served from the resource cache (long).
+ *
+ * The value may be retrieved via the \c BundleContext::GetProperty method.
+ *
+ * @see #FRAMEWORK_RESOURCE_CACHE_SIZE
+ */
+US_Framework_EXPORT extern const std::string
+  FRAMEWORK_RESOURCE_CACHE_HITS; // = "org.cppmicroservices.framework.resource.cache.hits";
+
+/**
+ * Read-only framework property holding the number of resource reads which
+ * decompressed the resource because it was not cached (long).
+ *
+ * The value may be retrieved via the \c BundleContext::GetProperty method.
+ *
+ * @see #FRAMEWORK_RESOURCE_CACHE_SIZE
+ */
+US_Framework_EXPORT extern const std::string
+  FRAMEWORK_RESOURCE_CACHE_MISSES; // = "org.cppmicroservices.framework.resource.cache.misses";
+
+/**
+ * Read-only framework property holding the number of resources which
+ * were evicted from the resource cache to make room for others (long).
+ *
+ * The value may be retrieved via the \c BundleContext::GetProperty method.
+ *
+ * @see #FRAMEWORK_RESOURCE_CACHE_SIZE
+ */
+US_Framework_EXPORT extern const std::string
+  FRAMEWORK_RESOURCE_CACHE_EVICTIONS; // = "org.cppmicroservices.framework.resource.cache.evictions";
+
 /**
  * Framework environment property identifying the Framework's universally
  * unique identifier (UUID). A UUID represents a 128-bit value. A new UUID
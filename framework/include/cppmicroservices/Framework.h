@@ -27,15 +27,49 @@
 #include "cppmicroservices/FrameworkConfig.h"
 
 #include <chrono>
+#include <exception>
 #include <map>
 #include <ostream>
 #include <string>
+#include <vector>
 
 namespace cppmicroservices {
 
 class FrameworkEvent;
 class FrameworkPrivate;
 
+/**
+ * \ingroup MicroServices
+ *
+ * Describes how a bundle was started by
+ * Framework::StartBundles(const std::vector<Bundle>&, uint32_t).
+ *
+ * All times are relative to the beginning of the batch.
+ */
+struct BundleStartTiming
+{
+  /** The bundle. */
+  Bundle bundle;
+
+  /** The time at which starting the bundle began. */
+  std::chrono::microseconds begin;
+
+  /** The time at which starting the bundle finished. */
+  std::chrono::microseconds end;
+
+  /** The bundles of the batch which had to be started first. */
+  std::vector<Bundle> dependencies;
+
+  /**
+   * \c true if the bundle is on the critical path of the batch, i.e.
+   * the chain of dependencies which finished last.
+   */
+  bool critical;
+
+  /** The exception thrown while starting the bundle, or \c nullptr. */
+  std::exception_ptr error;
+};
+
 /**
  * \ingroup MicroServices
  *
@@ -133,6 +167,40 @@ public:
      */
   FrameworkEvent WaitForStop(const std::chrono::milliseconds& timeout);
 
+  /**
+     * Start several bundles, starting independent bundles concurrently.
+     *
+     * <p>
+     * A bundle is only started after the bundles of the batch it depends
+     * on have been started. A bundle depends on another bundle if its
+     * library links against the library of the other bundle, or if its
+     * {@link Constants#BUNDLE_REQUIRES bundle.requires} manifest header
+     * lists the symbolic name of the other bundle. Dependencies on
+     * bundles which are not part of the batch are ignored, and cyclic
+     * dependencies are broken in the order of \c bundles.
+     *
+     * <p>
+     * Each bundle is started as by {@link Bundle#Start(uint32_t)}, which
+     * fires the <code>BUNDLE_STARTING</code> and <code>BUNDLE_STARTED</code>
+     * events of the bundle. With threading support, independent bundles
+     * are started on up to one thread per hardware thread.
+     *
+     * <p>
+     * Exceptions thrown while starting a bundle are recorded in the
+     * returned timings and published as framework events of type
+     * {@link FrameworkEvent#FRAMEWORK_ERROR}. Bundles depending on a bundle
+     * which failed to start are not started.
+     *
+     * @param bundles The bundles to start.
+     * @param options The options passed to {@link Bundle#Start(uint32_t)}.
+     * @return The timing of each bundle, in the order of \c bundles.
+     *
+     * @throws std::logic_error If one of the bundles is invalid.
+     */
+  std::vector<BundleStartTiming> StartBundles(
+    const std::vector<Bundle>& bundles,
+    uint32_t options = 0);
+
   /**
      * Start this Framework.
      *
@@ -25,6 +25,7 @@
 
 #include "cppmicroservices/GlobalConfig.h"
 #include "cppmicroservices/ServiceException.h"
+#include "cppmicroservices/detail/FlatInterfaceMap.h"
 
 #include <map>
 #include <memory>
@@ -56,6 +57,21 @@
 template<class T>
 const std::string& us_service_interface_iid();
 
+/**
+ * \ingroup MicroServices
+ * \ingroup gr_serviceinterface
+ *
+ * Returns a process wide integer id for a given type. The id is assigned
+ * to the interface id returned by us_service_interface_iid<T>() and is
+ * only looked up once per type. Different types with the same interface
+ * id share the same integer id.
+ *
+ * @tparam T The service interface type.
+ * @return The integer id for the service interface type T.
+ */
+template<class T>
+std::size_t us_service_interface_id();
+
 namespace cppmicroservices {
 
 class ServiceFactory;
@@ -71,13 +87,18 @@ class ServiceFactory;
  * the service interface id and the value a smart pointer to the service
  * interface implementation.
  *
+ * The map provides the std::map interface and the same value_type.
+ * Entries are kept in a flat array sorted by key, and a few entries are
+ * stored without any heap allocations. Unlike with std::map, inserting
+ * or erasing entries invalidates iterators and references to entries.
+ *
  * To create InterfaceMap instances, use the MakeInterfaceMap helper class.
  *
  * @note This is a low-level type and should only rarely be used.
  *
  * @see MakeInterfaceMap
  */
-using InterfaceMap = std::map<std::string, std::shared_ptr<void>>;
+using InterfaceMap = detail::FlatInterfaceMap;
 using InterfaceMapPtr = std::shared_ptr<InterfaceMap>;
 using InterfaceMapConstPtr = std::shared_ptr<const InterfaceMap>;
 
@@ -91,13 +112,12 @@ struct InsertInterfaceHelper
 {
   static void insert(InterfaceMapPtr& im, const Interfaces& interfaces)
   {
-    std::pair<std::string, std::shared_ptr<void>> aPair = std::make_pair(
-      std::string(
-        us_service_interface_iid<
-          typename std::tuple_element<size - 1,
-                                      Interfaces>::type::element_type>()),
+    using Interface =
+      typename std::tuple_element<size - 1, Interfaces>::type::element_type;
+    im->insert_id(
+      us_service_interface_id<Interface>(),
+      std::string(us_service_interface_iid<Interface>()),
       std::static_pointer_cast<void>(std::get<size - 1>(interfaces)));
-    im->insert(aPair);
     InsertInterfaceHelper<Interfaces, size - 1>::insert(im, interfaces);
   }
 };
@@ -160,6 +180,14 @@ inline const std::string& us_service_interface_iid<void>()
   static const std::string name("");
   return name;
 }
+
+template<class T>
+std::size_t us_service_interface_id()
+{
+  static const std::size_t id =
+    cppmicroservices::detail::GetInterfaceId(us_service_interface_iid<T>());
+  return id;
+}
 /// \endcond
 
 /**
@@ -308,8 +336,7 @@ private:
 template<class Interface>
 std::shared_ptr<Interface> ExtractInterface(const InterfaceMapConstPtr& map)
 {
-  auto iter =
-    map->find(us_service_interface_iid<Interface>());
+  auto iter = map->find_id(us_service_interface_id<Interface>());
   if (iter != map->end()) {
     return std::static_pointer_cast<Interface>(iter->second);
   }
@@ -23,6 +23,7 @@
 #ifndef CPPMICROSERVICES_BUNDLERESOURCEBUFFER_H
 #define CPPMICROSERVICES_BUNDLERESOURCEBUFFER_H
 
+#include "cppmicroservices/BundleResource.h"
 #include "cppmicroservices/FrameworkExport.h"
 
 #include <memory>
@@ -41,8 +42,15 @@ public:
   BundleResourceBuffer(const BundleResourceBuffer&) = delete;
   BundleResourceBuffer& operator=(const BundleResourceBuffer&) = delete;
 
-  explicit BundleResourceBuffer(std::unique_ptr<void, void (*)(void*)> data,
-                                std::size_t size,
+  explicit BundleResourceBuffer(BundleResourceView view,
+                                std::ios_base::openmode mode);
+
+  /**
+   * Reads the data of \c resource. Large deflated resources of memory
+   * mapped bundles are inflated incrementally, all other resources are
+   * read from BundleResource::GetView().
+   */
+  explicit BundleResourceBuffer(const BundleResource& resource,
                                 std::ios_base::openmode mode);
 
   ~BundleResourceBuffer() override;
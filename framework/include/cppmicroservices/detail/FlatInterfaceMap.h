@@ -0,0 +1,698 @@
+/*=============================================================================
+
+  Library: CppMicroServices
+
+  Copyright (c) The CppMicroServices developers. See the COPYRIGHT
+  file at the top-level directory of this distribution and at
+  https://github.com/CppMicroServices/CppMicroServices/COPYRIGHT .
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#ifndef CPPMICROSERVICES_FLATINTERFACEMAP_H
+#define CPPMICROSERVICES_FLATINTERFACEMAP_H
+
+#include "cppmicroservices/FrameworkExport.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace cppmicroservices {
+
+namespace detail {
+
+US_Framework_EXPORT std::size_t GetInterfaceId(
+  const std::string& interfaceName);
+
+/**
+ * A std::map style container mapping service interface ids to service
+ * object pointers, stored as a flat array sorted by key.
+ *
+ * Up to INLINE_CAPACITY entries are stored inside the container itself,
+ * which covers almost all services. Each entry also holds the interned
+ * integer id of its interface, see us_service_interface_id<T>(), so
+ * that interfaces can be found without comparing strings.
+ *
+ * The container provides the std::map interface, except for allocator
+ * support. In contrast to std::map, inserting or erasing entries
+ * invalidates iterators and references to entries.
+ */
+class FlatInterfaceMap
+{
+public:
+  using key_type = std::string;
+  using mapped_type = std::shared_ptr<void>;
+  using value_type = std::pair<const std::string, std::shared_ptr<void>>;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using key_compare = std::less<key_type>;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using pointer = value_type*;
+  using const_pointer = const value_type*;
+
+  class value_compare
+  {
+  public:
+    bool operator()(const value_type& lhs, const value_type& rhs) const
+    {
+      return comp(lhs.first, rhs.first);
+    }
+
+  protected:
+    friend class FlatInterfaceMap;
+
+    value_compare(key_compare c)
+      : comp(c)
+    {}
+
+    key_compare comp;
+  };
+
+  static const size_type INLINE_CAPACITY = 4;
+
+private:
+  struct Entry
+  {
+    template<class K, class M>
+    Entry(std::size_t id, K&& key, M&& mapped)
+      : id(id)
+      , value(std::forward<K>(key), std::forward<M>(mapped))
+    {}
+
+    // The key is const, so moving an entry copies its key
+    Entry(const Entry&) = default;
+    Entry(Entry&&) = default;
+
+    std::size_t id;
+    value_type value;
+  };
+
+  template<class E, class V>
+  class Iterator
+  {
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = FlatInterfaceMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = V*;
+    using reference = V&;
+
+    Iterator()
+      : m_entry(nullptr)
+    {}
+
+    // allow conversion from iterator to const_iterator
+    template<class E2, class V2>
+    Iterator(const Iterator<E2, V2>& other)
+      : m_entry(other.m_entry)
+    {}
+
+    reference operator*() const { return m_entry->value; }
+    pointer operator->() const { return &m_entry->value; }
+
+    Iterator& operator++()
+    {
+      ++m_entry;
+      return *this;
+    }
+
+    Iterator operator++(int)
+    {
+      Iterator tmp(*this);
+      ++m_entry;
+      return tmp;
+    }
+
+    Iterator& operator--()
+    {
+      --m_entry;
+      return *this;
+    }
+
+    Iterator operator--(int)
+    {
+      Iterator tmp(*this);
+      --m_entry;
+      return tmp;
+    }
+
+    template<class E2, class V2>
+    bool operator==(const Iterator<E2, V2>& other) const
+    {
+      return m_entry == other.m_entry;
+    }
+
+    template<class E2, class V2>
+    bool operator!=(const Iterator<E2, V2>& other) const
+    {
+      return m_entry != other.m_entry;
+    }
+
+  private:
+    friend class FlatInterfaceMap;
+    template<class, class>
+    friend class Iterator;
+
+    explicit Iterator(E* entry)
+      : m_entry(entry)
+    {}
+
+    E* m_entry;
+  };
+
+public:
+  using iterator = Iterator<Entry, value_type>;
+  using const_iterator = Iterator<const Entry, const value_type>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  FlatInterfaceMap()
+    : m_data(InlineData())
+    , m_size(0)
+    , m_capacity(INLINE_CAPACITY)
+  {}
+
+  template<class InputIterator>
+  FlatInterfaceMap(InputIterator first, InputIterator last)
+    : FlatInterfaceMap()
+  {
+    insert(first, last);
+  }
+
+  FlatInterfaceMap(std::initializer_list<value_type> values)
+    : FlatInterfaceMap(values.begin(), values.end())
+  {}
+
+  FlatInterfaceMap(const FlatInterfaceMap& other)
+    : FlatInterfaceMap()
+  {
+    CopyFrom(other);
+  }
+
+  FlatInterfaceMap(FlatInterfaceMap&& other)
+    : FlatInterfaceMap()
+  {
+    MoveFrom(other);
+  }
+
+  ~FlatInterfaceMap()
+  {
+    clear();
+    Deallocate();
+  }
+
+  FlatInterfaceMap& operator=(const FlatInterfaceMap& other)
+  {
+    if (this != &other) {
+      clear();
+      CopyFrom(other);
+    }
+    return *this;
+  }
+
+  FlatInterfaceMap& operator=(FlatInterfaceMap&& other)
+  {
+    if (this != &other) {
+      clear();
+      MoveFrom(other);
+    }
+    return *this;
+  }
+
+  FlatInterfaceMap& operator=(std::initializer_list<value_type> values)
+  {
+    clear();
+    insert(values);
+    return *this;
+  }
+
+  iterator begin() { return iterator(m_data); }
+  const_iterator begin() const { return const_iterator(m_data); }
+  const_iterator cbegin() const { return begin(); }
+
+  iterator end() { return iterator(m_data + m_size); }
+  const_iterator end() const { return const_iterator(m_data + m_size); }
+  const_iterator cend() const { return end(); }
+
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const
+  {
+    return const_reverse_iterator(end());
+  }
+  const_reverse_iterator crbegin() const { return rbegin(); }
+
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const
+  {
+    return const_reverse_iterator(begin());
+  }
+  const_reverse_iterator crend() const { return rend(); }
+
+  bool empty() const { return m_size == 0; }
+
+  size_type size() const { return m_size; }
+
+  size_type max_size() const
+  {
+    return static_cast<size_type>(
+             std::numeric_limits<difference_type>::max()) /
+           sizeof(Entry);
+  }
+
+  void clear()
+  {
+    Destroy(0, m_size);
+    m_size = 0;
+  }
+
+  key_compare key_comp() const { return key_compare(); }
+
+  value_compare value_comp() const { return value_compare(key_comp()); }
+
+  iterator find(const key_type& key)
+  {
+    Entry* entry = LowerBound(key);
+    return iterator(Matches(entry, key) ? entry : m_data + m_size);
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    return const_cast<FlatInterfaceMap*>(this)->find(key);
+  }
+
+  /**
+   * Find the entry for the interface with the interned id
+   * \c interfaceId.
+   */
+  const_iterator find_id(std::size_t interfaceId) const
+  {
+    const Entry* entry = m_data;
+    const Entry* last = m_data + m_size;
+    while (entry != last && entry->id != interfaceId) {
+      ++entry;
+    }
+    return const_iterator(entry);
+  }
+
+  size_type count(const key_type& key) const
+  {
+    return find(key) != end() ? 1 : 0;
+  }
+
+  iterator lower_bound(const key_type& key) { return iterator(LowerBound(key)); }
+
+  const_iterator lower_bound(const key_type& key) const
+  {
+    return const_iterator(LowerBound(key));
+  }
+
+  iterator upper_bound(const key_type& key)
+  {
+    Entry* entry = LowerBound(key);
+    return iterator(Matches(entry, key) ? entry + 1 : entry);
+  }
+
+  const_iterator upper_bound(const key_type& key) const
+  {
+    return const_cast<FlatInterfaceMap*>(this)->upper_bound(key);
+  }
+
+  std::pair<iterator, iterator> equal_range(const key_type& key)
+  {
+    return std::make_pair(lower_bound(key), upper_bound(key));
+  }
+
+  std::pair<const_iterator, const_iterator> equal_range(
+    const key_type& key) const
+  {
+    return std::make_pair(lower_bound(key), upper_bound(key));
+  }
+
+  mapped_type& at(const key_type& key)
+  {
+    auto iter = find(key);
+    if (iter == end()) {
+      throw std::out_of_range("FlatInterfaceMap::at: key not found");
+    }
+    return iter->second;
+  }
+
+  const mapped_type& at(const key_type& key) const
+  {
+    return const_cast<FlatInterfaceMap*>(this)->at(key);
+  }
+
+  mapped_type& operator[](const key_type& key)
+  {
+    return Emplace(key_type(key), mapped_type()).first->second;
+  }
+
+  mapped_type& operator[](key_type&& key)
+  {
+    return Emplace(std::move(key), mapped_type()).first->second;
+  }
+
+  std::pair<iterator, bool> insert(const value_type& value)
+  {
+    return Emplace(value.first, value.second);
+  }
+
+  std::pair<iterator, bool> insert(value_type&& value)
+  {
+    return Emplace(value.first, std::move(value.second));
+  }
+
+  template<class P,
+           class = typename std::enable_if<
+             std::is_constructible<value_type, P&&>::value>::type>
+  std::pair<iterator, bool> insert(P&& value)
+  {
+    return emplace(std::forward<P>(value));
+  }
+
+  iterator insert(const_iterator, const value_type& value)
+  {
+    return insert(value).first;
+  }
+
+  iterator insert(const_iterator, value_type&& value)
+  {
+    return insert(std::move(value)).first;
+  }
+
+  template<class P,
+           class = typename std::enable_if<
+             std::is_constructible<value_type, P&&>::value>::type>
+  iterator insert(const_iterator, P&& value)
+  {
+    return emplace(std::forward<P>(value)).first;
+  }
+
+  template<class InputIterator>
+  void insert(InputIterator first, InputIterator last)
+  {
+    for (; first != last; ++first) {
+      insert(*first);
+    }
+  }
+
+  void insert(std::initializer_list<value_type> values)
+  {
+    insert(values.begin(), values.end());
+  }
+
+  template<class... Args>
+  std::pair<iterator, bool> emplace(Args&&... args)
+  {
+    // Construct a pair with a non-const key, which can be moved into
+    // the new entry.
+    std::pair<key_type, mapped_type> value(std::forward<Args>(args)...);
+    return Emplace(std::move(value.first), std::move(value.second));
+  }
+
+  template<class... Args>
+  iterator emplace_hint(const_iterator, Args&&... args)
+  {
+    return emplace(std::forward<Args>(args)...).first;
+  }
+
+  /**
+   * Insert \c mapped for the interface \c key with the interned id
+   * \c interfaceId, which must be the id of \c key. This avoids looking
+   * up the id again.
+   */
+  std::pair<iterator, bool> insert_id(std::size_t interfaceId,
+                                      key_type&& key,
+                                      mapped_type&& mapped)
+  {
+    Entry* pos = LowerBound(key);
+    if (Matches(pos, key)) {
+      return std::make_pair(iterator(pos), false);
+    }
+    return std::make_pair(
+      Insert(pos - m_data, interfaceId, std::move(key), std::move(mapped)),
+      true);
+  }
+
+  iterator erase(const_iterator pos) { return erase(pos, std::next(pos)); }
+
+  iterator erase(iterator pos) { return erase(const_iterator(pos)); }
+
+  iterator erase(const_iterator first, const_iterator last)
+  {
+    const size_type index = first.m_entry - m_data;
+    Erase(index, last.m_entry - first.m_entry);
+    return iterator(m_data + index);
+  }
+
+  size_type erase(const key_type& key)
+  {
+    auto iter = find(key);
+    if (iter == end()) {
+      return 0;
+    }
+    erase(iter);
+    return 1;
+  }
+
+  void swap(FlatInterfaceMap& other)
+  {
+    FlatInterfaceMap tmp(std::move(other));
+    other = std::move(*this);
+    *this = std::move(tmp);
+  }
+
+  bool operator==(const FlatInterfaceMap& other) const
+  {
+    return m_size == other.m_size &&
+           std::equal(begin(), end(), other.begin());
+  }
+
+  bool operator!=(const FlatInterfaceMap& other) const
+  {
+    return !(*this == other);
+  }
+
+  bool operator<(const FlatInterfaceMap& other) const
+  {
+    return std::lexicographical_compare(
+      begin(), end(), other.begin(), other.end());
+  }
+
+  bool operator>(const FlatInterfaceMap& other) const { return other < *this; }
+
+  bool operator<=(const FlatInterfaceMap& other) const
+  {
+    return !(other < *this);
+  }
+
+  bool operator>=(const FlatInterfaceMap& other) const
+  {
+    return !(*this < other);
+  }
+
+private:
+  using Storage =
+    typename std::aligned_storage<sizeof(Entry), alignof(Entry)>::type;
+
+  Entry* InlineData() { return reinterpret_cast<Entry*>(m_inline); }
+
+  bool IsInline() const
+  {
+    return m_data == reinterpret_cast<const Entry*>(m_inline);
+  }
+
+  Entry* LowerBound(const key_type& key) const
+  {
+    return std::lower_bound(
+      m_data, m_data + m_size, key, [](const Entry& entry, const key_type& k) {
+        return entry.value.first < k;
+      });
+  }
+
+  bool Matches(const Entry* entry, const key_type& key) const
+  {
+    return entry != m_data + m_size && entry->value.first == key;
+  }
+
+  template<class K, class M>
+  std::pair<iterator, bool> Emplace(K&& key, M&& mapped)
+  {
+    Entry* pos = LowerBound(key);
+    if (Matches(pos, key)) {
+      return std::make_pair(iterator(pos), false);
+    }
+    std::size_t id = GetInterfaceId(key);
+    return std::make_pair(
+      Insert(pos - m_data, id, std::forward<K>(key), std::forward<M>(mapped)),
+      true);
+  }
+
+  void Destroy(size_type first, size_type last)
+  {
+    for (; first < last; ++first) {
+      m_data[first].~Entry();
+    }
+  }
+
+  /**
+   * Insert a new entry at \c index. If the storage is full, the entries
+   * are copied into a larger array, which leaves the map unchanged if
+   * an exception is thrown. Otherwise the entries after \c index are
+   * moved, and if moving an entry throws, the entries from \c index on
+   * are lost.
+   */
+  template<class K, class M>
+  iterator Insert(size_type index, std::size_t id, K&& key, M&& mapped)
+  {
+    if (m_size == m_capacity) {
+      const size_type capacity = 2 * m_capacity;
+      Entry* data =
+        static_cast<Entry*>(::operator new(capacity * sizeof(Entry)));
+      try {
+        new (data + index)
+          Entry(id, std::forward<K>(key), std::forward<M>(mapped));
+      } catch (...) {
+        ::operator delete(data);
+        throw;
+      }
+      size_type constructed = 0;
+      try {
+        for (; constructed < index; ++constructed) {
+          new (data + constructed) Entry(m_data[constructed]);
+        }
+        for (; constructed < m_size; ++constructed) {
+          new (data + constructed + 1) Entry(m_data[constructed]);
+        }
+      } catch (...) {
+        for (size_type i = 0; i < constructed; ++i) {
+          data[i < index ? i : i + 1].~Entry();
+        }
+        data[index].~Entry();
+        ::operator delete(data);
+        throw;
+      }
+      clear();
+      Deallocate();
+      m_data = data;
+      m_size = constructed + 1;
+      m_capacity = capacity;
+      return iterator(m_data + index);
+    }
+
+    Entry entry(id, std::forward<K>(key), std::forward<M>(mapped));
+    size_type i = m_size;
+    try {
+      for (; i > index; --i) {
+        new (m_data + i) Entry(std::move(m_data[i - 1]));
+        m_data[i - 1].~Entry();
+      }
+      new (m_data + index) Entry(std::move(entry));
+    } catch (...) {
+      // The slot i is empty
+      Destroy(i + 1, m_size + 1);
+      m_size = i;
+      throw;
+    }
+    ++m_size;
+    return iterator(m_data + index);
+  }
+
+  /**
+   * Erase \c count entries starting at \c index. If moving an entry
+   * throws, the entries after the erased ones are lost.
+   */
+  void Erase(size_type index, size_type count)
+  {
+    if (count == 0) {
+      return;
+    }
+    Destroy(index, index + count);
+    size_type i = index;
+    try {
+      for (; i + count < m_size; ++i) {
+        new (m_data + i) Entry(std::move(m_data[i + count]));
+        m_data[i + count].~Entry();
+      }
+    } catch (...) {
+      // The slots from i to i + count - 1 are empty
+      Destroy(i + count, m_size);
+      m_size = i;
+      throw;
+    }
+    m_size -= count;
+  }
+
+  // requires this map to be empty
+  void CopyFrom(const FlatInterfaceMap& other)
+  {
+    if (other.m_size > m_capacity) {
+      Deallocate();
+      m_data =
+        static_cast<Entry*>(::operator new(other.m_size * sizeof(Entry)));
+      m_capacity = other.m_size;
+    }
+    for (; m_size < other.m_size; ++m_size) {
+      new (m_data + m_size) Entry(other.m_data[m_size]);
+    }
+  }
+
+  // requires this map to be empty
+  void MoveFrom(FlatInterfaceMap& other)
+  {
+    if (!other.IsInline()) {
+      Deallocate();
+      m_data = other.m_data;
+      m_size = other.m_size;
+      m_capacity = other.m_capacity;
+      other.m_data = other.InlineData();
+      other.m_size = 0;
+      other.m_capacity = INLINE_CAPACITY;
+    } else {
+      // Inline entries are copied, so that other is unchanged if
+      // copying a key throws.
+      CopyFrom(other);
+      other.clear();
+    }
+  }
+
+  void Deallocate()
+  {
+    if (!IsInline()) {
+      ::operator delete(m_data);
+      m_data = InlineData();
+      m_capacity = INLINE_CAPACITY;
+    }
+  }
+
+  Storage m_inline[INLINE_CAPACITY];
+  Entry* m_data;
+  size_type m_size;
+  size_type m_capacity;
+};
+}
+}
+
+#endif // CPPMICROSERVICES_FLATINTERFACEMAP_H
@@ -26,6 +26,7 @@
 
 #include "cppmicroservices/BundleResource.h"
 
+#include "BundleResourceCache.h"
 #include "BundleResourceContainer.h"
 #include "BundleStorage.h"
 
@@ -41,15 +42,32 @@ BundleArchive::BundleArchive()
 {}
 
 BundleArchive::BundleArchive(BundleStorage* storage,
+                             std::shared_ptr<BundleResourceCache> resourceCache,
                              std::unique_ptr<Data>&& data,
                              std::shared_ptr<BundleResourceContainer>  resourceContainer,
                              std::string  resourcePrefix,
                              std::string  location)
   : storage(storage)
+  , resourceCache(std::move(resourceCache))
   , data(std::move(data))
-  , resourceContainer(std::move(resourceContainer))
   , resourcePrefix(std::move(resourcePrefix))
   , location(std::move(location))
+{
+  this->resourceContainer.v = std::move(resourceContainer);
+}
+
+BundleArchive::BundleArchive(BundleStorage* storage,
+                             std::shared_ptr<BundleResourceCache> resourceCache,
+                             std::unique_ptr<Data>&& data,
+                             std::string resourcePrefix,
+                             std::string location,
+                             std::string manifest)
+  : storage(storage)
+  , resourceCache(std::move(resourceCache))
+  , data(std::move(data))
+  , resourcePrefix(std::move(resourcePrefix))
+  , location(std::move(location))
+  , manifest(std::move(manifest))
 {}
 
 bool BundleArchive::IsValid() const
@@ -59,6 +77,9 @@ bool BundleArchive::IsValid() const
 
 void BundleArchive::Purge()
 {
+  if (resourceCache) {
+    resourceCache->Remove(GetBundleId());
+  }
   storage->RemoveArchive(this);
 }
 
@@ -79,7 +100,7 @@ std::string BundleArchive::GetResourcePrefix() const
 
 BundleResource BundleArchive::GetResource(const std::string& path) const
 {
-  if (!resourceContainer) {
+  if (!GetResourceContainer()) {
     return BundleResource();
   }
   BundleResource result(path, this->shared_from_this());
@@ -94,6 +115,7 @@ std::vector<BundleResource> BundleArchive::FindResources(
   bool recurse) const
 {
   std::vector<BundleResource> result;
+  auto resourceContainer = GetResourceContainer();
   if (!resourceContainer) {
     return result;
   }
@@ -124,6 +146,7 @@ void BundleArchive::SetLastModified(const TimeStamp& ts)
   data->lastModified =
     std::chrono::duration_cast<std::chrono::milliseconds>(ts.time_since_epoch())
       .count();
+  storage->UpdateArchive(this);
 }
 
 int32_t BundleArchive::GetAutostartSetting() const
@@ -134,11 +157,28 @@ int32_t BundleArchive::GetAutostartSetting() const
 void BundleArchive::SetAutostartSetting(int32_t setting)
 {
   data->autostartSetting = setting;
+  storage->UpdateArchive(this);
 }
 
 std::shared_ptr<BundleResourceContainer>
 BundleArchive::GetResourceContainer() const
 {
-  return resourceContainer;
+  auto l = resourceContainer.Lock();
+  US_UNUSED(l);
+  if (!resourceContainer.v && storage && data) {
+    resourceContainer.v = storage->OpenResourceContainer(location);
+  }
+  return resourceContainer.v;
+}
+
+const std::string& BundleArchive::GetCachedManifest() const
+{
+  return manifest;
+}
+
+const std::shared_ptr<BundleResourceCache>& BundleArchive::GetResourceCache()
+  const
+{
+  return resourceCache;
 }
 }
@@ -23,6 +23,8 @@
 #ifndef CPPMICROSERVICES_BUNDLEARCHIVE_H
 #define CPPMICROSERVICES_BUNDLEARCHIVE_H
 
+#include "cppmicroservices/detail/Threads.h"
+
 #include <memory>
 #include <string>
 #include <vector>
@@ -33,6 +35,7 @@ namespace cppmicroservices {
 class BundleResource;
 class BundleResourceContainer;
 struct BundleStorage;
+class BundleResourceCache;
 
 /**
  * Class for managing bundle data.
@@ -54,11 +57,25 @@ struct BundleArchive : std::enable_shared_from_this<BundleArchive>
   BundleArchive();
 
   BundleArchive(BundleStorage* storage,
+                std::shared_ptr<BundleResourceCache> resourceCache,
                 std::unique_ptr<Data>&& data,
                 std::shared_ptr<BundleResourceContainer>  resourceContainer,
                 std::string  resourcePrefix,
                 std::string  location);
 
+  /**
+   * Construct a bundle archive restored from persistent storage. The
+   * resource container is opened when it is first needed.
+   *
+   * @param manifest The cached content of the bundle's manifest.json file.
+   */
+  BundleArchive(BundleStorage* storage,
+                std::shared_ptr<BundleResourceCache> resourceCache,
+                std::unique_ptr<Data>&& data,
+                std::string resourcePrefix,
+                std::string location,
+                std::string manifest);
+
   /**
    * Autostart setting stopped.
    *
@@ -154,14 +171,37 @@ struct BundleArchive : std::enable_shared_from_this<BundleArchive>
    */
   void SetAutostartSetting(int32_t setting);
 
+  /**
+   * Get the resource container, opening it if this archive was restored
+   * from persistent storage.
+   */
   std::shared_ptr<BundleResourceContainer> GetResourceContainer() const;
 
+  /**
+   * Get the cached content of the bundle's manifest.json file.
+   *
+   * @return The manifest or an empty string if it is not cached.
+   */
+  const std::string& GetCachedManifest() const;
+
+  /**
+   * Get the framework's cache for decompressed resource data.
+   *
+   * @return The cache or null for an invalid archive.
+   */
+  const std::shared_ptr<BundleResourceCache>& GetResourceCache() const;
+
 private:
   BundleStorage* const storage;
+  const std::shared_ptr<BundleResourceCache> resourceCache;
   const std::unique_ptr<Data> data;
-  const std::shared_ptr<BundleResourceContainer> resourceContainer;
+  mutable struct : detail::MultiThreaded<>
+  {
+    std::shared_ptr<BundleResourceContainer> v;
+  } resourceContainer;
   const std::string resourcePrefix;
   const std::string location;
+  const std::string manifest;
 };
 }
 
@@ -89,7 +89,12 @@ Any BundleContext::GetProperty(const std::string& key) const
   // won the race condition.
 
   auto iter = b->coreCtx->frameworkProperties.find(key);
-  return iter == b->coreCtx->frameworkProperties.end() ? Any() : iter->second;
+  if (iter != b->coreCtx->frameworkProperties.end()) {
+    return iter->second;
+  }
+  auto runtimeProps = b->coreCtx->GetRuntimeProperties();
+  iter = runtimeProps.find(key);
+  return iter == runtimeProps.end() ? Any() : iter->second;
 }
 
 AnyMap BundleContext::GetProperties() const
@@ -102,7 +107,11 @@ AnyMap BundleContext::GetProperties() const
   // the result is the same as if the calling thread had
   // won the race condition.
 
-  return b->coreCtx->frameworkProperties;
+  AnyMap props(b->coreCtx->frameworkProperties);
+  for (auto& prop : b->coreCtx->GetRuntimeProperties()) {
+    props.emplace(prop.first, prop.second);
+  }
+  return props;
 }
 
 Bundle BundleContext::GetBundle() const
@@ -495,4 +504,13 @@ std::vector<Bundle> BundleContext::InstallBundles(const std::string& location)
 
   return b->coreCtx->bundleRegistry.Install(location, b);
 }
+
+std::vector<Bundle> BundleContext::InstallBundles(
+  const std::vector<std::string>& locations)
+{
+  d->CheckValid();
+  auto b = (d->Lock(), d->bundle);
+
+  return b->coreCtx->bundleRegistry.Install(locations, b);
+}
 }
@@ -47,7 +47,7 @@ Bundle BundleHooks::FilterBundle(const BundleContext& context,
   }
 
   std::vector<ServiceRegistrationBase> srl;
-  coreCtx->services.Get(us_service_interface_iid<BundleFindHook>(), srl);
+  coreCtx->services.Get(us_service_interface_id<BundleFindHook>(), srl);
   if (srl.empty()) {
     return bundle;
   } else {
@@ -62,7 +62,7 @@ void BundleHooks::FilterBundles(const BundleContext& context,
                                 std::vector<Bundle>& bundles) const
 {
   std::vector<ServiceRegistrationBase> srl;
-  coreCtx->services.Get(us_service_interface_iid<BundleFindHook>(), srl);
+  coreCtx->services.Get(us_service_interface_id<BundleFindHook>(), srl);
   ShrinkableVector<Bundle> filtered(bundles);
 
   auto selfBundle = GetBundleContext().GetBundle();
@@ -95,7 +95,7 @@ void BundleHooks::FilterBundleEventReceivers(
   ServiceListeners::BundleListenerMap& bundleListeners)
 {
   std::vector<ServiceRegistrationBase> eventHooks;
-  coreCtx->services.Get(us_service_interface_iid<BundleEventHook>(),
+  coreCtx->services.Get(us_service_interface_id<BundleEventHook>(),
                         eventHooks);
 
   {
@@ -48,6 +48,7 @@
 #include <cassert>
 #include <cstring>
 #include <iterator>
+#include <sstream>
 #include <chrono>
 
 namespace cppmicroservices {
@@ -380,6 +381,30 @@ void BundlePrivate::FinalizeActivation(LockType& l)
   }
 }
 
+void BundlePrivate::TriggerLazyActivation()
+{
+  // Avoid taking the resolver lock for bundles which are not waiting
+  // for their lazy activation.
+  if (!lazyActivation || state != Bundle::STATE_STARTING) {
+    return;
+  }
+
+  try {
+    auto l = coreCtx->resolver.Lock();
+    // The activation is already in progress if the operation is not
+    // idle, e.g. when the bundle activator itself gets a service.
+    if (state == Bundle::STATE_STARTING && operation == OP_IDLE) {
+      FinalizeActivation(l);
+    }
+  } catch (...) {
+    coreCtx->listeners.SendFrameworkEvent(
+      FrameworkEvent(FrameworkEvent::Type::FRAMEWORK_ERROR,
+                     MakeBundle(shared_from_this()),
+                     std::string("Lazy activation of bundle failed"),
+                     std::current_exception()));
+  }
+}
+
 void BundlePrivate::Uninstall()
 {
   {
@@ -511,7 +536,7 @@ void BundlePrivate::Start(uint32_t options)
 
     // 3: Record non-transient start requests.
     if ((options & Bundle::START_TRANSIENT) == 0) {
-      //setAutostartSetting(options);
+      SetAutostartSetting(options & Bundle::START_ACTIVATION_POLICY);
     }
 
     // 5: Lazy?
@@ -715,6 +740,7 @@ std::shared_ptr<BundleThread> BundlePrivate::GetBundleThread()
   } else {
     bundleThread = coreCtx->bundleThreads.value.front();
     coreCtx->bundleThreads.value.pop_front();
+    bundleThread->isIdle = false;
   }
 
   return bundleThread;
@@ -747,6 +773,79 @@ bool BundlePrivate::IsFragment() const
   return fragment != nullptr;
 }
 
+bool BundlePrivate::ServiceSet::Insert(const ServiceRegistrationBase& reg)
+{
+  if (positions.count(reg)) {
+    return false;
+  }
+  auto pos = regs.insert(regs.end(), reg);
+  try {
+    positions.emplace(reg, pos);
+  } catch (...) {
+    regs.erase(pos);
+    throw;
+  }
+  return true;
+}
+
+void BundlePrivate::ServiceSet::Erase(const ServiceRegistrationBase& reg)
+{
+  auto iter = positions.find(reg);
+  if (iter != positions.end()) {
+    regs.erase(iter->second);
+    positions.erase(iter);
+  }
+}
+
+std::vector<ServiceRegistrationBase> BundlePrivate::ServiceSet::ToVector()
+  const
+{
+  return std::vector<ServiceRegistrationBase>(regs.begin(), regs.end());
+}
+
+void BundlePrivate::AddRegisteredService(const ServiceRegistrationBase& reg)
+{
+  auto l = serviceIndex.Lock();
+  US_UNUSED(l);
+  serviceIndex.registered.Insert(reg);
+}
+
+void BundlePrivate::RemoveRegisteredService(const ServiceRegistrationBase& reg)
+{
+  auto l = serviceIndex.Lock();
+  US_UNUSED(l);
+  serviceIndex.registered.Erase(reg);
+}
+
+std::vector<ServiceRegistrationBase> BundlePrivate::GetRegisteredServices()
+  const
+{
+  auto l = serviceIndex.Lock();
+  US_UNUSED(l);
+  return serviceIndex.registered.ToVector();
+}
+
+void BundlePrivate::AddUsedService(const ServiceRegistrationBase& reg)
+{
+  auto l = serviceIndex.Lock();
+  US_UNUSED(l);
+  serviceIndex.used.Insert(reg);
+}
+
+void BundlePrivate::RemoveUsedService(const ServiceRegistrationBase& reg)
+{
+  auto l = serviceIndex.Lock();
+  US_UNUSED(l);
+  serviceIndex.used.Erase(reg);
+}
+
+std::vector<ServiceRegistrationBase> BundlePrivate::GetUsedServices() const
+{
+  auto l = serviceIndex.Lock();
+  US_UNUSED(l);
+  return serviceIndex.used.ToVector();
+}
+
 BundlePrivate::BundlePrivate(CoreBundleContext* coreCtx)
   : coreCtx(coreCtx)
   , id(0)
@@ -802,7 +901,19 @@ BundlePrivate::BundlePrivate(CoreBundleContext* coreCtx,
   , SetBundleContext(nullptr)
 {
   // Check if the bundle provides a manifest.json file and if yes, parse it.
-  if (barchive->IsValid()) {
+  // Archives restored from persistent storage cache their manifest, which
+  // avoids opening the bundle library.
+  if (barchive->IsValid() && !barchive->GetCachedManifest().empty()) {
+    std::istringstream manifestStream(barchive->GetCachedManifest());
+    try {
+      bundleManifest.Parse(manifestStream);
+    } catch (...) {
+      throw std::runtime_error(
+        std::string("Parsing of cached manifest.json for bundle ") +
+        symbolicName + " at " + location +
+        " failed: " + util::GetLastExceptionStr());
+    }
+  } else if (barchive->IsValid()) {
     auto manifestRes = barchive->GetResource("/manifest.json");
     if (manifestRes) {
       BundleResourceStream manifestStream(manifestRes);
@@ -859,6 +970,19 @@ BundlePrivate::BundlePrivate(CoreBundleContext* coreCtx,
                                 symbolicName + ".");
   }
 
+  if (bundleManifest.Contains(Constants::BUNDLE_ACTIVATIONPOLICY)) {
+    Any policy(bundleManifest.GetValue(Constants::BUNDLE_ACTIVATIONPOLICY));
+    if (policy.Type() != typeid(std::string)) {
+      throw std::invalid_argument(std::string("The Json value for ") +
+                                  Constants::BUNDLE_ACTIVATIONPOLICY +
+                                  " for bundle " + symbolicName +
+                                  " must be a string");
+    }
+    // Unknown policies are ignored and the bundle is activated eagerly
+    lazyActivation =
+      ref_any_cast<std::string>(policy) == Constants::ACTIVATION_LAZY;
+  }
+
   auto snbl = coreCtx->bundleRegistry.GetBundles(symbolicName, version);
   if (!snbl.empty()) {
     throw std::invalid_argument(
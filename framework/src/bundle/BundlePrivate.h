@@ -25,6 +25,7 @@
 
 #include "cppmicroservices/Bundle.h"
 #include "cppmicroservices/BundleVersion.h"
+#include "cppmicroservices/ServiceRegistrationBase.h"
 #include "cppmicroservices/SharedLibrary.h"
 #include "cppmicroservices/detail/Threads.h"
 #include "cppmicroservices/detail/WaitCondition.h"
@@ -36,6 +37,9 @@
 #include <ostream>
 #include <thread>
 #include <functional>
+#include <list>
+#include <unordered_map>
+#include <vector>
 
 namespace cppmicroservices {
 
@@ -162,6 +166,15 @@ using WaitConditionType = WaitCondition<MutexHost>;
   // Performs the actual activation.
   void FinalizeActivation(LockType& l);
 
+  /**
+   * Activates this bundle if it was started according to its lazy
+   * activation policy and has not been activated yet. Failures are
+   * published as framework events.
+   *
+   * Must be called without any locks held.
+   */
+  void TriggerLazyActivation();
+
   virtual void Uninstall();
 
   virtual std::string GetLocation() const;
@@ -189,6 +202,39 @@ using WaitConditionType = WaitCondition<MutexHost>;
    */
   bool IsFragment() const;
 
+  /**
+   * Record a service registered by this bundle. Called by the service
+   * registry with the registry lock held.
+   */
+  void AddRegisteredService(const ServiceRegistrationBase& reg);
+
+  void RemoveRegisteredService(const ServiceRegistrationBase& reg);
+
+  /**
+   * Get the services registered by this bundle, in registration order.
+   */
+  std::vector<ServiceRegistrationBase> GetRegisteredServices() const;
+
+  /**
+   * Record a service which this bundle got. Called with the lock of the
+   * registration held, whenever the bundle is added to its dependents
+   * or prototype service instances.
+   */
+  void AddUsedService(const ServiceRegistrationBase& reg);
+
+  /**
+   * Remove a service which this bundle does not use any more. Called
+   * with the lock of the registration held.
+   */
+  void RemoveUsedService(const ServiceRegistrationBase& reg);
+
+  /**
+   * Get the services which this bundle might use. The result may
+   * contain services which were released concurrently, use
+   * ServiceRegistrationBasePrivate::IsUsedByBundle to check.
+   */
+  std::vector<ServiceRegistrationBase> GetUsedServices() const;
+
   /**
    * Framework context.
    */
@@ -319,6 +365,44 @@ using WaitConditionType = WaitCondition<MutexHost>;
 
   using SetBundleContextHook = std::function<void (BundleContextPrivate*)>;
   SetBundleContextHook SetBundleContext;
+
+private:
+  /**
+   * Registrations kept in insertion order, with a hash index into the
+   * list so that adding, finding and removing one are constant time.
+   */
+  class ServiceSet
+  {
+  public:
+    /**
+     * Append \c reg unless it is already present.
+     *
+     * @return \c true if \c reg was added.
+     */
+    bool Insert(const ServiceRegistrationBase& reg);
+
+    /**
+     * Remove \c reg if present.
+     */
+    void Erase(const ServiceRegistrationBase& reg);
+
+    std::vector<ServiceRegistrationBase> ToVector() const;
+
+  private:
+    using List = std::list<ServiceRegistrationBase>;
+    List regs;
+    std::unordered_map<ServiceRegistrationBase, List::iterator> positions;
+  };
+
+  /**
+   * Index of the services registered and used by this bundle, so that
+   * they can be found without visiting all registrations.
+   */
+  struct : detail::MultiThreaded<>
+  {
+    ServiceSet registered;
+    ServiceSet used;
+  } serviceIndex;
 };
 
 Bundle MakeBundle(const std::shared_ptr<BundlePrivate>& d);
@@ -37,9 +37,12 @@
 #include "BundleStorage.h"
 #include "CoreBundleContext.h"
 #include "FrameworkPrivate.h"
+#include "Parallel.h"
 
+#include <algorithm>
 #include <cassert>
 #include <map>
+#include <unordered_map>
 
 namespace cppmicroservices {
 
@@ -51,8 +54,7 @@ BundleRegistry::~BundleRegistry() = default;
 
 void BundleRegistry::Init()
 {
-  bundles.v.insert(
-    std::make_pair(coreCtx->systemBundle->location, coreCtx->systemBundle));
+  Insert_unlocked(coreCtx->systemBundle->location, coreCtx->systemBundle);
 }
 
 void BundleRegistry::Clear()
@@ -60,6 +62,8 @@ void BundleRegistry::Clear()
   auto l = bundles.Lock();
   US_UNUSED(l);
   bundles.v.clear();
+  bundles.byId.clear();
+  bundles.byName.clear();
 }
 
 std::vector<Bundle> BundleRegistry::Install(const std::string& location,
@@ -69,6 +73,59 @@ std::vector<Bundle> BundleRegistry::Install(const std::string& location,
 
   auto l = this->Lock();
   US_UNUSED(l);
+  return Install_unlocked(location, caller);
+}
+
+std::vector<Bundle> BundleRegistry::Install(
+  const std::vector<std::string>& locations,
+  BundlePrivate* caller)
+{
+  CheckIllegalState();
+
+  auto l = this->Lock();
+  US_UNUSED(l);
+
+  // Maps each location which is not installed yet to its index in
+  // newLocations.
+  std::unordered_map<std::string, std::size_t> newIndex;
+  std::vector<std::string> newLocations;
+  {
+    auto l2 = bundles.Lock();
+    US_UNUSED(l2);
+    for (auto& location : locations) {
+      if (bundles.v.count(location) == 0 &&
+          newIndex.insert(std::make_pair(location, newLocations.size()))
+            .second) {
+        newLocations.push_back(location);
+      }
+    }
+  }
+
+  auto newBundles = InstallNew_unlocked(newLocations);
+
+  // Locations which were installed before or which are repeated are
+  // handled like in a single install.
+  std::vector<Bundle> res;
+  std::vector<bool> done(newLocations.size(), false);
+  for (auto& location : locations) {
+    auto iter = newIndex.find(location);
+    if (iter != newIndex.end() && !done[iter->second]) {
+      done[iter->second] = true;
+      res.insert(res.end(),
+                 newBundles[iter->second].begin(),
+                 newBundles[iter->second].end());
+    } else {
+      auto installed = Install_unlocked(location, caller);
+      res.insert(res.end(), installed.begin(), installed.end());
+    }
+  }
+  return res;
+}
+
+std::vector<Bundle> BundleRegistry::Install_unlocked(
+  const std::string& location,
+  BundlePrivate* caller)
+{
   auto range = (bundles.Lock(), bundles.v.equal_range(location));
   if (range.first != range.second) {
     std::vector<Bundle> res;
@@ -126,7 +183,7 @@ std::vector<Bundle> BundleRegistry::Install0(
       auto l = bundles.Lock();
       US_UNUSED(l);
       for (auto& b : res) {
-        bundles.v.insert(std::make_pair(location, b.d));
+        Insert_unlocked(location, b.d);
       }
     }
 
@@ -144,6 +201,112 @@ std::vector<Bundle> BundleRegistry::Install0(
   }
 }
 
+std::vector<std::vector<Bundle>> BundleRegistry::InstallNew_unlocked(
+  const std::vector<std::string>& locations)
+{
+  const std::size_t n = locations.size();
+  std::vector<std::vector<Bundle>> res(n);
+  std::vector<std::shared_ptr<BundleResourceContainer>> containers(n);
+  std::vector<std::vector<std::shared_ptr<BundleArchive>>> barchives(n);
+  std::vector<std::exception_ptr> errors(n);
+
+  auto purge = [&barchives]() {
+    for (auto& bas : barchives) {
+      for (auto& ba : bas) {
+        ba->Purge();
+      }
+    }
+  };
+
+  auto rethrow = [&locations, &errors, &purge]() {
+    for (std::size_t i = 0; i < errors.size(); ++i) {
+      if (errors[i]) {
+        purge();
+        throw std::runtime_error("Failed to install bundle library at " +
+                                 locations[i] + ": " +
+                                 util::GetExceptionStr(errors[i]));
+      }
+    }
+  };
+
+  // Opening a container reads the zip archive and the object file
+  ParallelFor(n, [&](std::size_t i) {
+    try {
+      containers[i] = std::make_shared<BundleResourceContainer>(locations[i]);
+    } catch (...) {
+      errors[i] = std::current_exception();
+    }
+  });
+  rethrow();
+  // Bundle ids are assigned in the order of the locations
+  for (std::size_t i = 0; i < n; ++i) {
+    try {
+      barchives[i] = coreCtx->storage->InsertArchives(
+        containers[i], containers[i]->GetTopLevelDirs());
+    } catch (...) {
+      errors[i] = std::current_exception();
+      break;
+    }
+  }
+  rethrow();
+  // Bundles sharing a container are created by the same thread, since
+  // the BundlePrivate constructor may close the container.
+  ParallelFor(n, [&](std::size_t i) {
+    try {
+      for (auto& ba : barchives[i]) {
+        auto d = std::shared_ptr<BundlePrivate>(new BundlePrivate(coreCtx, ba));
+        res[i].emplace_back(MakeBundle(d));
+      }
+    } catch (...) {
+      errors[i] = std::current_exception();
+    }
+  });
+  rethrow();
+  {
+    auto l = bundles.Lock();
+    US_UNUSED(l);
+
+    // The BundlePrivate constructor only checks for duplicates which
+    // are already installed, not for duplicates within this batch.
+    std::unordered_multimap<std::string, const BundlePrivate*> batch;
+    for (std::size_t i = 0; i < n; ++i) {
+      for (auto& b : res[i]) {
+        auto sameVersion = [&b](const auto& p) {
+          return p.second->version == b.d->version;
+        };
+        auto range = bundles.byName.equal_range(b.d->symbolicName);
+        auto batchRange = batch.equal_range(b.d->symbolicName);
+        bool duplicate =
+          std::any_of(range.first, range.second, sameVersion) ||
+          std::any_of(batchRange.first, batchRange.second, sameVersion);
+        if (duplicate) {
+          purge();
+          throw std::runtime_error(
+            "Failed to install bundle library at " + locations[i] +
+            ": a bundle with same symbolic name and version is already "
+            "installed (" +
+            b.d->symbolicName + ", " + b.d->version.ToString() + ")");
+        }
+        batch.insert(std::make_pair(b.d->symbolicName, b.d.get()));
+      }
+    }
+
+    for (std::size_t i = 0; i < n; ++i) {
+      for (auto& b : res[i]) {
+        Insert_unlocked(locations[i], b.d);
+      }
+    }
+  }
+
+  for (auto& bs : res) {
+    for (auto& b : bs) {
+      coreCtx->listeners.BundleChanged(
+        BundleEvent(BundleEvent::BUNDLE_INSTALLED, b));
+    }
+  }
+  return res;
+}
+
 void BundleRegistry::Remove(const std::string& location, long id)
 {
   auto l = bundles.Lock();
@@ -151,7 +314,7 @@ void BundleRegistry::Remove(const std::string& location, long id)
   auto range = bundles.v.equal_range(location);
   for (auto iter = range.first; iter != range.second; ++iter) {
     if (iter->second->id == id) {
-      bundles.v.erase(iter);
+      Erase_unlocked(iter);
       return;
     }
   }
@@ -164,12 +327,8 @@ std::shared_ptr<BundlePrivate> BundleRegistry::GetBundle(long id) const
   auto l = bundles.Lock();
   US_UNUSED(l);
 
-  for (auto& m : bundles.v) {
-    if (m.second->id == id) {
-      return m.second;
-    }
-  }
-  return nullptr;
+  auto iter = bundles.byId.find(id);
+  return iter != bundles.byId.end() ? iter->second : nullptr;
 }
 
 std::vector<std::shared_ptr<BundlePrivate>> BundleRegistry::GetBundles(
@@ -200,9 +359,10 @@ std::vector<std::shared_ptr<BundlePrivate>> BundleRegistry::GetBundles(
   auto l = bundles.Lock();
   US_UNUSED(l);
 
-  for (auto& p : bundles.v) {
-    auto& b = p.second;
-    if (name == b->symbolicName && version == b->version) {
+  auto range = bundles.byName.equal_range(name);
+  for (auto iter = range.first; iter != range.second; ++iter) {
+    auto& b = iter->second;
+    if (version == b->version) {
       res.push_back(b);
     }
   }
@@ -248,9 +408,12 @@ void BundleRegistry::Load()
   for (auto const& ba : bas) {
     try {
       std::shared_ptr<BundlePrivate> impl(new BundlePrivate(coreCtx, ba));
-      bundles.v.insert(std::make_pair(impl->location, impl));
+      auto l2 = bundles.Lock();
+      US_UNUSED(l2);
+      Insert_unlocked(impl->location, impl);
     } catch (...) {
       ba->SetAutostartSetting(-1); // Do not start on launch
+      ba->Purge();
       std::cerr << "Failed to load bundle " << util::ToString(ba->GetBundleId())
                 << " (" + ba->GetBundleLocation() + ") uninstalled it!"
                 << " (execption: "
@@ -260,6 +423,28 @@ void BundleRegistry::Load()
   }
 }
 
+void BundleRegistry::Insert_unlocked(const std::string& location,
+                                     const std::shared_ptr<BundlePrivate>& b)
+{
+  bundles.v.insert(std::make_pair(location, b));
+  bundles.byId.insert(std::make_pair(b->id, b));
+  bundles.byName.insert(std::make_pair(b->symbolicName, b));
+}
+
+void BundleRegistry::Erase_unlocked(BundleMap::iterator iter)
+{
+  const auto& b = iter->second;
+  bundles.byId.erase(b->id);
+  auto range = bundles.byName.equal_range(b->symbolicName);
+  for (auto nameIter = range.first; nameIter != range.second; ++nameIter) {
+    if (nameIter->second == b) {
+      bundles.byName.erase(nameIter);
+      break;
+    }
+  }
+  bundles.v.erase(iter);
+}
+
 void BundleRegistry::CheckIllegalState() const
 {
   if (coreCtx == nullptr) {
@@ -28,6 +28,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace cppmicroservices {
@@ -64,6 +65,23 @@ public:
   std::vector<Bundle> Install(const std::string& location,
                               BundlePrivate* caller);
 
+  /**
+   * Install several bundle libraries.
+   *
+   * Opening the bundle containers and parsing the bundle manifests of
+   * locations which are not installed yet is done concurrently.
+   * Bundles are added to the registry and BUNDLE_INSTALLED events are
+   * sent in the order of <code>locations</code>. If one of the new
+   * locations cannot be installed, none of them is installed.
+   *
+   * @param locations The locations to be installed
+   * @param caller The bundle performing the install
+   * @return A vector of bundles installed, in the order of
+   *         <code>locations</code>
+   */
+  std::vector<Bundle> Install(const std::vector<std::string>& locations,
+                              BundlePrivate* caller);
+
   std::vector<Bundle> Install0(
     const std::string& location,
     const std::vector<std::shared_ptr<BundlePrivate>>& exclude,
@@ -136,18 +154,51 @@ private:
 
   void CheckIllegalState() const;
 
+  /**
+   * Install a bundle library. Requires the registry lock.
+   */
+  std::vector<Bundle> Install_unlocked(const std::string& location,
+                                       BundlePrivate* caller);
+
+  /**
+   * Install bundle libraries which are not installed yet. Requires the
+   * registry lock.
+   *
+   * @return The installed bundles for each location.
+   */
+  std::vector<std::vector<Bundle>> InstallNew_unlocked(
+    const std::vector<std::string>& locations);
+
   CoreBundleContext* coreCtx;
 
 using BundleMap = std::multimap<std::string, std::shared_ptr<BundlePrivate>>;
+  using BundleIdMap = std::unordered_map<long, std::shared_ptr<BundlePrivate>>;
+  using BundleNameMap =
+    std::unordered_multimap<std::string, std::shared_ptr<BundlePrivate>>;
 
   /**
    * Table of all installed bundles in this framework.
-   * Key is the bundle location.
+   * Key is the bundle location. The id and symbolic name indices
+   * contain the same bundles and are kept in sync by Insert_unlocked
+   * and Erase_unlocked.
    */
   struct : MultiThreaded<>
   {
     BundleMap v;
+    BundleIdMap byId;
+    BundleNameMap byName;
   } bundles;
+
+  /**
+   * Add a bundle to all bundle tables. Requires the bundles lock.
+   */
+  void Insert_unlocked(const std::string& location,
+                       const std::shared_ptr<BundlePrivate>& b);
+
+  /**
+   * Remove a bundle from all bundle tables. Requires the bundles lock.
+   */
+  void Erase_unlocked(BundleMap::iterator iter);
 };
 }
 
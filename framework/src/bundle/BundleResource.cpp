@@ -26,6 +26,7 @@
 #include "cppmicroservices/detail/Log.h"
 
 #include "BundleArchive.h"
+#include "BundleResourceCache.h"
 #include "BundleResourceContainer.h"
 
 #include <atomic>
@@ -286,20 +287,49 @@ std::size_t BundleResource::Hash() const
                              this->GetResourcePath());
 }
 
-std::unique_ptr<void, void (*)(void*)> BundleResource::GetData() const
+BundleResourceView BundleResource::GetView() const
 {
   if (!IsValid())
-    return { nullptr, ::free };
-
-  auto data = d->archive->GetResourceContainer()->GetData(d->stat.index);
-  if (!data) {
-    auto sink = GetBundleContext().GetLogSink();
-    DIAG_LOG(*sink) << "Error uncompressing resource data for "
-                    << this->GetResourcePath() << " from "
-                    << d->archive->GetBundleLocation();
+    return {};
+
+  auto container = d->archive->GetResourceContainer();
+  const auto size = static_cast<std::size_t>(d->stat.uncompressedSize);
+  if (auto stored = container->GetStoredData(d->stat.index)) {
+    return { std::move(stored), size };
+  }
+
+  auto load = [this, &container]() -> std::shared_ptr<const char> {
+    auto data = container->GetData(d->stat.index);
+    if (!data) {
+      auto sink = GetBundleContext().GetLogSink();
+      DIAG_LOG(*sink) << "Error uncompressing resource data for "
+                      << this->GetResourcePath() << " from "
+                      << d->archive->GetBundleLocation();
+      return nullptr;
+    }
+    return { static_cast<const char*>(data.release()),
+             [](const char* p) { ::free(const_cast<char*>(p)); } };
+  };
+
+  const auto& cache = d->archive->GetResourceCache();
+  if (!cache) {
+    return { load(), size };
   }
+  return { cache->Get(
+             { d->archive->GetBundleId(), d->stat.index, d->stat.crc32 },
+             size,
+             load),
+           size };
+}
+
+BundleResourceView BundleResource::GetDeflatedView() const
+{
+  if (!IsValid())
+    return {};
 
-  return data;
+  auto data =
+    d->archive->GetResourceContainer()->GetDeflatedData(d->stat.index);
+  return { std::move(data), static_cast<std::size_t>(d->stat.compressedSize) };
 }
 
 std::ostream& operator<<(std::ostream& os, const BundleResource& resource)
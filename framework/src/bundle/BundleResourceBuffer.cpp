@@ -22,6 +22,8 @@
 
 #include "cppmicroservices/detail/BundleResourceBuffer.h"
 
+#include "miniz.h"
+
 #include <cassert>
 #include <cstdint>
 #include <limits>
@@ -40,10 +42,43 @@ namespace cppmicroservices {
 
 namespace detail {
 
+/**
+ * Incrementally inflates a raw deflate stream. The window doubles as the
+ * dictionary of the decompressor and holds the most recently inflated
+ * bytes.
+ */
+struct InflateState
+{
+  InflateState(BundleResourceView deflated, std::size_t size, uint32_t crc32)
+    : deflated(std::move(deflated))
+    , size(size)
+    , crc32(crc32)
+    , inOffset(0)
+    , produced(0)
+    , windowOffset(0)
+    , runningCrc(MZ_CRC32_INIT)
+    , window(new mz_uint8[TINFL_LZ_DICT_SIZE])
+  {
+    tinfl_init(&inflator);
+  }
+
+  const BundleResourceView deflated;
+  const std::size_t size;
+  const uint32_t crc32;
+
+  std::size_t inOffset;
+  std::size_t produced;
+  std::size_t windowOffset;
+  mz_ulong runningCrc;
+
+  tinfl_decompressor inflator;
+  std::unique_ptr<mz_uint8[]> window;
+};
+
 class BundleResourceBufferPrivate
 {
 public:
-  BundleResourceBufferPrivate(std::unique_ptr<void, void (*)(void*)> data,
+  BundleResourceBufferPrivate(BundleResourceView view,
                               std::size_t size,
                               const char* begin,
                               std::ios_base::openmode mode)
@@ -51,20 +86,60 @@ public:
     , end(begin + size)
     , current(begin)
     , mode(mode)
-    , uncompressedData(reinterpret_cast<unsigned char*>(data.release()),
-                       data.get_deleter())
+    , view(std::move(view))
+    , windowPos(0)
 #ifdef DATA_NEEDS_NEWLINE_CONVERSION
     , pos(0)
 #endif
   {}
 
-  const char* const begin;
-  const char* const end;
+  BundleResourceBufferPrivate(std::unique_ptr<InflateState> inflate,
+                              std::ios_base::openmode mode)
+    : begin(nullptr)
+    , end(nullptr)
+    , current(nullptr)
+    , mode(mode)
+    , windowPos(0)
+    , inflate(std::move(inflate))
+#ifdef DATA_NEEDS_NEWLINE_CONVERSION
+    , pos(0)
+#endif
+  {
+    Restart();
+  }
+
+  std::streamoff Position() const { return windowPos + (current - begin); }
+
+  /// Inflate the next window. Returns false at the end of the data or if
+  /// the data is corrupt.
+  bool Refill();
+
+  /// Restart inflating from the beginning of the data.
+  void Restart();
+
+  /// Move to the absolute position target, inflating as needed.
+  /// Returns the new position or -1 if target is out of range.
+  std::streamoff Seek(std::streamoff target);
+
+  /// The number of readable bytes, which in text mode is only known
+  /// after inflating the last window.
+  std::streamoff Size();
+
+  // The readable data, which is a window of the inflated data
+  // if inflate is set.
+  const char* begin;
+  const char* end;
   const char* current;
 
   const std::ios_base::openmode mode;
 
-  std::unique_ptr<unsigned char, void (*)(void*)> uncompressedData;
+  // keeps the data alive, which may be mapped or decompressed memory
+  const BundleResourceView view;
+
+  // stream position of begin
+  std::streamoff windowPos;
+
+  std::unique_ptr<InflateState> inflate;
 
 #ifdef DATA_NEEDS_NEWLINE_CONVERSION
   // records the stream position ignoring CR characters
@@ -72,40 +147,160 @@ public:
 #endif
 };
 
-BundleResourceBuffer::BundleResourceBuffer(
-  std::unique_ptr<void, void (*)(void*)> data,
-  std::size_t _size,
+bool BundleResourceBufferPrivate::Refill()
+{
+  InflateState& s = *inflate;
+  if (s.produced == s.size) {
+    return false;
+  }
+
+  if (s.windowOffset == TINFL_LZ_DICT_SIZE) {
+    s.windowOffset = 0;
+  }
+  std::size_t inBytes = s.deflated.size() - s.inOffset;
+  std::size_t outBytes = TINFL_LZ_DICT_SIZE - s.windowOffset;
+  mz_uint8* out = s.window.get() + s.windowOffset;
+  tinfl_decompress(
+    &s.inflator,
+    reinterpret_cast<const mz_uint8*>(s.deflated.data()) + s.inOffset,
+    &inBytes,
+    s.window.get(),
+    out,
+    &outBytes,
+    0);
+  s.inOffset += inBytes;
+  if (outBytes == 0 || s.produced + outBytes > s.size) {
+    return false;
+  }
+
+  windowPos = static_cast<std::streamoff>(s.produced);
+  begin = reinterpret_cast<const char*>(out);
+  end = begin + outBytes;
+  current = begin;
+  s.windowOffset += outBytes;
+  s.produced += outBytes;
+  s.runningCrc = mz_crc32(s.runningCrc, out, outBytes);
+
+  if (s.produced == s.size) {
+    if (s.runningCrc != s.crc32) {
+      end = current = begin;
+      return false;
+    }
+#ifdef REMOVE_LAST_NEWLINE_IN_TEXT_MODE
+    if (!(mode & std::ios_base::binary) && end[-1] == '\n') {
+      --end;
+    }
+#endif
+  }
+  return current != end;
+}
+
+void BundleResourceBufferPrivate::Restart()
+{
+  InflateState& s = *inflate;
+  tinfl_init(&s.inflator);
+  s.inOffset = 0;
+  s.produced = 0;
+  s.windowOffset = 0;
+  s.runningCrc = MZ_CRC32_INIT;
+  windowPos = 0;
+  begin = end = current = reinterpret_cast<const char*>(s.window.get());
+}
+
+std::streamoff BundleResourceBufferPrivate::Seek(std::streamoff target)
+{
+  if (target < 0) {
+    return -1;
+  }
+  if (target < windowPos) {
+    Restart();
+  }
+  while (target > windowPos + (end - begin)) {
+    if (!Refill()) {
+      return -1;
+    }
+  }
+  current = begin + (target - windowPos);
+  return target;
+}
+
+std::streamoff BundleResourceBufferPrivate::Size()
+{
+  if (mode & std::ios_base::binary) {
+    return static_cast<std::streamoff>(inflate->size);
+  }
+  while (inflate->produced < inflate->size) {
+    if (!Refill()) {
+      return -1;
+    }
+  }
+  return windowPos + (end - begin);
+}
+
+namespace {
+
+std::unique_ptr<BundleResourceBufferPrivate> MakeBufferPrivate(
+  BundleResourceView view,
   std::ios_base::openmode mode)
-  : d(nullptr)
 {
-  assert(_size <
+  assert(view.size() <
          static_cast<std::size_t>(std::numeric_limits<uint32_t>::max()));
 
-  auto* begin = reinterpret_cast<char*>(data.get());
-  std::size_t size = begin ? _size : 0;
+  const char* begin = view.data();
+  std::size_t size = view.size();
 
 #ifdef DATA_NEEDS_NEWLINE_CONVERSION
-  if (begin != nullptr && !(mode & std::ios_base::binary) && begin[0] == '\r') {
+  if (size > 0 && !(mode & std::ios_base::binary) && begin[0] == '\r') {
     ++begin;
     --size;
   }
 #endif
 
 #ifdef REMOVE_LAST_NEWLINE_IN_TEXT_MODE
-  if (begin != nullptr && !(mode & std::ios_base::binary) &&
+  if (size > 0 && !(mode & std::ios_base::binary) &&
       begin[size - 1] == '\n') {
     --size;
   }
 #endif
 
-  d = std::make_unique<BundleResourceBufferPrivate>(std::move(data), size, begin, mode);
+  return std::make_unique<BundleResourceBufferPrivate>(
+    std::move(view), size, begin, mode);
+}
+}
+
+BundleResourceBuffer::BundleResourceBuffer(BundleResourceView view,
+                                           std::ios_base::openmode mode)
+  : d(MakeBufferPrivate(std::move(view), mode))
+{}
+
+BundleResourceBuffer::BundleResourceBuffer(const BundleResource& resource,
+                                           std::ios_base::openmode mode)
+  : d(nullptr)
+{
+#ifndef DATA_NEEDS_NEWLINE_CONVERSION
+  // Inflating into a window only saves memory for resources which are
+  // larger than the window.
+  if (resource.GetSize() > TINFL_LZ_DICT_SIZE) {
+    auto deflated = resource.GetDeflatedView();
+    if (!deflated.empty()) {
+      d = std::make_unique<BundleResourceBufferPrivate>(
+        std::make_unique<InflateState>(
+          std::move(deflated),
+          static_cast<std::size_t>(resource.GetSize()),
+          resource.GetCrc32()),
+        mode);
+      return;
+    }
+  }
+#endif
+  d = MakeBufferPrivate(resource.GetView(), mode);
 }
 
 BundleResourceBuffer::~BundleResourceBuffer() = default;
 
 BundleResourceBuffer::int_type BundleResourceBuffer::underflow()
 {
-  if (d->current == d->end)
+  if (d->current == d->end && !(d->inflate && d->Refill()))
     return traits_type::eof();
 
 #ifdef DATA_NEEDS_NEWLINE_CONVERSION
@@ -126,7 +321,7 @@ BundleResourceBuffer::int_type BundleResourceBuffer::underflow()
 
 BundleResourceBuffer::int_type BundleResourceBuffer::uflow()
 {
-  if (d->current == d->end)
+  if (d->current == d->end && !(d->inflate && d->Refill()))
     return traits_type::eof();
 
 #ifdef DATA_NEEDS_NEWLINE_CONVERSION
@@ -147,6 +342,14 @@ BundleResourceBuffer::int_type BundleResourceBuffer::uflow()
 
 BundleResourceBuffer::int_type BundleResourceBuffer::pbackfail(int_type ch)
 {
+  if (d->inflate && d->current == d->begin && d->windowPos > 0) {
+    // The previous character was in an earlier window. Re-inflating up
+    // to the current position ends with a window which contains it.
+    const std::streamoff position = d->windowPos;
+    d->Restart();
+    d->Seek(position);
+  }
+
   int backOffset = -1;
 #ifdef DATA_NEEDS_NEWLINE_CONVERSION
   if (!(d->mode & std::ios_base::binary)) {
@@ -189,6 +392,19 @@ std::streambuf::pos_type BundleResourceBuffer::seekoff(
   std::ios_base::seekdir way,
   std::ios_base::openmode /*which*/)
 {
+  if (d->inflate) {
+    std::streamoff base = 0;
+    if (way == std::ios_base::cur) {
+      base = d->Position();
+    } else if (way == std::ios_base::end) {
+      base = d->Size();
+    }
+    if (base < 0) {
+      return pos_type(off_type(-1));
+    }
+    return d->Seek(base + off);
+  }
+
 #ifdef DATA_NEEDS_NEWLINE_CONVERSION
   std::streambuf::off_type step = 1;
   if (way == std::ios_base::beg) {
@@ -0,0 +1,147 @@
+/*=============================================================================
+
+  Library: CppMicroServices
+
+  Copyright (c) The CppMicroServices developers. See the COPYRIGHT
+  file at the top-level directory of this distribution and at
+  https://github.com/CppMicroServices/CppMicroServices/COPYRIGHT .
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#include "BundleResourceCache.h"
+
+#include <iterator>
+
+namespace cppmicroservices {
+
+std::size_t BundleResourceCache::KeyHash::operator()(const Key& key) const
+{
+  std::size_t h = std::hash<long>()(key.bundleId);
+  h ^= std::hash<int>()(key.index) + 0x9e3779b9 + (h << 6) + (h >> 2);
+  h ^= std::hash<uint32_t>()(key.crc32) + 0x9e3779b9 + (h << 6) + (h >> 2);
+  return h;
+}
+
+BundleResourceCache::BundleResourceCache(std::size_t capacity)
+  : capacity(capacity)
+  , lru()
+  , index()
+  , size(0)
+  , hits(0)
+  , misses(0)
+  , evictions(0)
+{}
+
+std::shared_ptr<const char> BundleResourceCache::Get(const Key& key,
+                                                     std::size_t size,
+                                                     const Loader& load)
+{
+  if (capacity == 0) {
+    return load();
+  }
+
+  {
+    auto l = this->Lock();
+    US_UNUSED(l);
+    auto iter = index.find(key);
+    if (iter != index.end()) {
+      ++hits;
+      lru.splice(lru.begin(), lru, iter->second);
+      return iter->second->data;
+    }
+  }
+
+  ++misses;
+
+  // Decompress without holding the lock, so that a slow load does not
+  // block lookups of already cached resources.
+  auto data = load();
+  if (!data || size > capacity) {
+    return data;
+  }
+
+  auto l = this->Lock();
+  US_UNUSED(l);
+  auto iter = index.find(key);
+  if (iter != index.end()) {
+    // another thread cached the same resource in the meantime
+    lru.splice(lru.begin(), lru, iter->second);
+    return iter->second->data;
+  }
+
+  while (this->size + size > capacity) {
+    Erase_unlocked(std::prev(lru.end()));
+    ++evictions;
+  }
+  lru.push_front(Entry{ key, size, data });
+  index.insert(std::make_pair(key, lru.begin()));
+  this->size += size;
+  return data;
+}
+
+void BundleResourceCache::Remove(long bundleId)
+{
+  auto l = this->Lock();
+  US_UNUSED(l);
+  for (auto iter = lru.begin(); iter != lru.end();) {
+    auto next = std::next(iter);
+    if (iter->key.bundleId == bundleId) {
+      Erase_unlocked(iter);
+    }
+    iter = next;
+  }
+}
+
+void BundleResourceCache::Clear()
+{
+  auto l = this->Lock();
+  US_UNUSED(l);
+  index.clear();
+  lru.clear();
+  size = 0;
+}
+
+std::size_t BundleResourceCache::Size() const
+{
+  return this->Lock(), size;
+}
+
+std::size_t BundleResourceCache::Capacity() const
+{
+  return capacity;
+}
+
+std::size_t BundleResourceCache::Hits() const
+{
+  return hits;
+}
+
+std::size_t BundleResourceCache::Misses() const
+{
+  return misses;
+}
+
+std::size_t BundleResourceCache::Evictions() const
+{
+  return evictions;
+}
+
+void BundleResourceCache::Erase_unlocked(LruList::iterator iter)
+{
+  size -= iter->size;
+  index.erase(iter->key);
+  lru.erase(iter);
+}
+}
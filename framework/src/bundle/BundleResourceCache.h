@@ -0,0 +1,139 @@
+/*=============================================================================
+
+  Library: CppMicroServices
+
+  Copyright (c) The CppMicroServices developers. See the COPYRIGHT
+  file at the top-level directory of this distribution and at
+  https://github.com/CppMicroServices/CppMicroServices/COPYRIGHT .
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#ifndef CPPMICROSERVICES_BUNDLERESOURCECACHE_H
+#define CPPMICROSERVICES_BUNDLERESOURCECACHE_H
+
+#include "cppmicroservices/detail/Threads.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+namespace cppmicroservices {
+
+/**
+ * A thread-safe cache of decompressed resource data, shared by all
+ * bundles of a framework and bounded by a byte budget.
+ *
+ * Cached buffers are immutable and reference counted, so a cache hit
+ * only costs a hash lookup and a reference count increment instead of
+ * decompressing the resource again. Buffers stay valid while they are
+ * referenced, even after they were evicted. When the budget is exceeded,
+ * the least recently used entries are evicted.
+ *
+ * This class is not part of the public API.
+ */
+class BundleResourceCache : private detail::MultiThreaded<>
+{
+
+public:
+  struct Key
+  {
+    long bundleId;
+    int index;
+    uint32_t crc32;
+
+    bool operator==(const Key& o) const
+    {
+      return bundleId == o.bundleId && index == o.index && crc32 == o.crc32;
+    }
+  };
+
+  using Loader = std::function<std::shared_ptr<const char>()>;
+
+  /**
+   * @param capacity The byte budget. A capacity of zero disables caching.
+   */
+  explicit BundleResourceCache(std::size_t capacity);
+
+  BundleResourceCache(const BundleResourceCache&) = delete;
+  BundleResourceCache& operator=(const BundleResourceCache&) = delete;
+
+  /**
+   * Return the cached data of \c size bytes for \c key, calling \c load
+   * and caching its result if it is not already cached. Results of
+   * \c load which are null or larger than the capacity are not cached.
+   */
+  std::shared_ptr<const char> Get(const Key& key,
+                                  std::size_t size,
+                                  const Loader& load);
+
+  //! Remove all cached entries of a bundle, e.g. when it is uninstalled.
+  void Remove(long bundleId);
+
+  //! Remove all cached entries. The counters are not reset.
+  void Clear();
+
+  //! Number of cached bytes.
+  std::size_t Size() const;
+
+  std::size_t Capacity() const;
+
+  //! Number of Get() calls which were served from the cache.
+  std::size_t Hits() const;
+
+  //! Number of Get() calls which required loading the data.
+  std::size_t Misses() const;
+
+  //! Number of entries which were evicted to stay within the capacity.
+  std::size_t Evictions() const;
+
+private:
+  struct KeyHash
+  {
+    std::size_t operator()(const Key& key) const;
+  };
+
+  struct Entry
+  {
+    Key key;
+    std::size_t size;
+    std::shared_ptr<const char> data;
+  };
+
+  using LruList = std::list<Entry>;
+
+  void Erase_unlocked(LruList::iterator iter);
+
+  const std::size_t capacity;
+
+  /**
+   * Cached entries, ordered from most recently used to least
+   * recently used.
+   */
+  LruList lru;
+
+  std::unordered_map<Key, LruList::iterator, KeyHash> index;
+
+  std::size_t size;
+
+  std::atomic<std::size_t> hits;
+  std::atomic<std::size_t> misses;
+  std::atomic<std::size_t> evictions;
+};
+}
+
+#endif // CPPMICROSERVICES_BUNDLERESOURCECACHE_H
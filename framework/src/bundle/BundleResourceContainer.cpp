@@ -29,8 +29,15 @@
 #include "cppmicroservices/GetBundleContext.h"
 #include "cppmicroservices/detail/Log.h"
 
+#if defined(US_PLATFORM_APPLE) || defined(US_PLATFORM_POSIX)
+#  include "cppmicroservices/util/MappedFile.h"
+#endif
+
+#include <algorithm>
 #include <cassert>
+#include <cctype>
 #include <climits>
+#include <cstdlib>
 #include <cstring>
 #include <exception>
 #include <iostream>
@@ -40,10 +47,88 @@
 
 namespace cppmicroservices {
 
+namespace {
+
+const std::size_t LOCAL_HEADER_SIZE = 30;
+const uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+
+uint32_t ReadLE16(const unsigned char* p)
+{
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8);
+}
+
+uint32_t ReadLE32(const unsigned char* p)
+{
+  return ReadLE16(p) | (ReadLE16(p + 2) << 16);
+}
+
+std::size_t CaseFoldedHash(const char* name, std::size_t length)
+{
+  // FNV-1a over the ASCII lower case characters
+  std::uint64_t hash = 14695981039346656037ULL;
+  for (std::size_t i = 0; i < length; ++i) {
+    char c = name[i];
+    if (c >= 'A' && c <= 'Z') {
+      c = static_cast<char>(c - 'A' + 'a');
+    }
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ULL;
+  }
+  return static_cast<std::size_t>(hash);
+}
+
+bool EqualsCaseInsensitive(const char* a, const char* b, std::size_t length)
+{
+  for (std::size_t i = 0; i < length; ++i) {
+    if (std::tolower(static_cast<unsigned char>(a[i])) !=
+        std::tolower(static_cast<unsigned char>(b[i]))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Match name against the tokens of a file pattern split at '*'. Like
+/// before, the tokens only need to occur in order somewhere in the name.
+bool Matches(const char* first,
+             const char* last,
+             const std::vector<std::string>& patternTokens)
+{
+  for (auto const& tok : patternTokens) {
+    first = std::search(first, last, tok.begin(), tok.end());
+    if (first == last && !tok.empty()) {
+      return false;
+    }
+    first += tok.size();
+  }
+  return true;
+}
+
+#if defined(US_PLATFORM_APPLE) || defined(US_PLATFORM_POSIX)
+/// Map the whole file at location read-only. Returns null on failure.
+std::shared_ptr<const char> MapFile(const std::string& location,
+                                    std::size_t& size)
+{
+  struct stat info;
+  if (::stat(location.c_str(), &info) != 0 || info.st_size <= 0) {
+    return nullptr;
+  }
+  size = static_cast<std::size_t>(info.st_size);
+  auto mapping = std::make_shared<MappedFile>(location, size, 0);
+  if (!mapping->GetMappedAddress()) {
+    return nullptr;
+  }
+  return { mapping, static_cast<const char*>(mapping->GetMappedAddress()) };
+}
+#endif
+}
+
 BundleResourceContainer::BundleResourceContainer(const std::string& location)
   : m_Location(location)
   , m_ZipArchive()
   , m_ObjFile()
+  , m_MappedData()
+  , m_Dependencies()
   , m_ZipFileMutex()
   , m_IsContainerOpen(false)
 {
@@ -52,7 +137,15 @@ BundleResourceContainer::BundleResourceContainer(const std::string& location)
   }
 
   InitMiniz();
- 
+  // The object file is released when the container is closed, so read
+  // the dependencies now.
+  if (m_ObjFile) {
+    try {
+      m_Dependencies = m_ObjFile->GetDependencies();
+    } catch (const std::exception&) {
+    }
+  }
+
   InitSortedEntries();
   if (m_SortedToplevelDirs.empty()) {
     throw std::runtime_error("Invalid zip archive layout for bundle at " +
@@ -79,16 +172,17 @@ std::vector<std::string> BundleResourceContainer::GetTopLevelDirs() const
                                    m_SortedToplevelDirs.end() };
 }
 
+std::vector<std::string> BundleResourceContainer::GetDependencies() const
+{
+  return m_Dependencies;
+}
+
 bool BundleResourceContainer::GetStat(BundleResourceContainer::Stat& stat)
 {
-  OpenContainer();
-  int fileIndex =
-    mz_zip_reader_locate_file(const_cast<mz_zip_archive*>(&m_ZipArchive),
-                              stat.filePath.c_str(),
-                              nullptr,
-                              0);
-  if (fileIndex >= 0) {
-    return GetStat(fileIndex, stat);
+  // Zip entry names are case-insensitive, as in mz_zip_reader_locate_file.
+  int32_t entry = FindEntry(stat.filePath, false);
+  if (entry >= 0) {
+    return GetStat(m_Entries[static_cast<std::size_t>(entry)].index, stat);
   }
   return false;
 }
@@ -127,36 +221,124 @@ std::unique_ptr<void, void (*)(void*)> BundleResourceContainer::GetData(
   int index)
 {
   OpenContainer();
+
+  MappedEntry entry;
+  if (GetMappedEntry(index, entry)) {
+    // Each call inflates with its own decompressor straight from the
+    // mapping, so concurrent calls do not serialize.
+    const auto size = static_cast<std::size_t>(entry.uncompressedSize);
+    std::unique_ptr<void, void (*)(void*)> data(std::malloc(size ? size : 1),
+                                                ::free);
+    if (!data) {
+      return { nullptr, ::free };
+    }
+    std::size_t outSize = 0;
+    if (entry.method == 0 && entry.compressedSize == size) {
+      std::memcpy(data.get(), entry.data, size);
+      outSize = size;
+    } else if (entry.method == MZ_DEFLATED) {
+      outSize = tinfl_decompress_mem_to_mem(
+        data.get(),
+        size,
+        entry.data,
+        static_cast<std::size_t>(entry.compressedSize),
+        TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF);
+    }
+    if (outSize != size ||
+        mz_crc32(MZ_CRC32_INIT,
+                 static_cast<const mz_uint8*>(data.get()),
+                 size) != entry.crc32) {
+      return { nullptr, ::free };
+    }
+    return data;
+  }
+
   std::unique_lock<std::mutex> l(m_ZipFileStreamMutex);
   void* data = mz_zip_reader_extract_to_heap(
     const_cast<mz_zip_archive*>(&m_ZipArchive), index, nullptr, 0);
   return { data, ::free };
 }
 
+std::shared_ptr<const char> BundleResourceContainer::GetStoredData(int index)
+{
+  OpenContainer();
+  MappedEntry entry;
+  if (!GetMappedEntry(index, entry) || entry.method != 0 ||
+      entry.compressedSize != entry.uncompressedSize) {
+    return nullptr;
+  }
+  return { entry.archive, entry.data };
+}
+
+std::shared_ptr<const char> BundleResourceContainer::GetDeflatedData(int index)
+{
+  OpenContainer();
+  MappedEntry entry;
+  if (!GetMappedEntry(index, entry) || entry.method != MZ_DEFLATED) {
+    return nullptr;
+  }
+  return { entry.archive, entry.data };
+}
+
+bool BundleResourceContainer::GetMappedEntry(int index, MappedEntry& entry)
+{
+  // The central directory is released when the container is closed.
+  std::lock_guard<std::mutex> lock(m_ZipFileMutex);
+  mz_zip_archive_file_stat zipStat;
+  if (!m_MappedData || index < 0 ||
+      !mz_zip_reader_file_stat(&m_ZipArchive, index, &zipStat)) {
+    return false;
+  }
+
+  // The data follows the local header, whose file name and extra field
+  // lengths may differ from the ones in the central directory.
+  const mz_uint64 archiveSize = m_ZipArchive.m_archive_size;
+  const mz_uint64 headerOffset =
+    m_ZipArchive.m_archive_file_ofs + zipStat.m_local_header_ofs;
+  if (headerOffset + LOCAL_HEADER_SIZE > archiveSize) {
+    return false;
+  }
+  const auto* header =
+    reinterpret_cast<const unsigned char*>(m_MappedData.get()) + headerOffset;
+  if (ReadLE32(header) != LOCAL_HEADER_SIGNATURE) {
+    return false;
+  }
+  const mz_uint64 dataOffset = headerOffset + LOCAL_HEADER_SIZE +
+                               ReadLE16(header + 26) + ReadLE16(header + 28);
+  if (dataOffset + zipStat.m_comp_size > archiveSize) {
+    return false;
+  }
+
+  entry.archive = m_MappedData;
+  entry.data = m_MappedData.get() + dataOffset;
+  entry.compressedSize = zipStat.m_comp_size;
+  entry.uncompressedSize = zipStat.m_uncomp_size;
+  entry.crc32 = zipStat.m_crc32;
+  entry.method = zipStat.m_method;
+  return true;
+}
+
 void BundleResourceContainer::GetChildren(const std::string& resourcePath,
                                           bool relativePaths,
                                           std::vector<std::string>& names,
                                           std::vector<uint32_t>& indices) const
 {
-  auto iter = m_SortedEntries.find(std::make_pair(resourcePath, 0));
-  if (iter == m_SortedEntries.end()) {
+  int32_t entry = FindEntry(resourcePath, true);
+  if (entry < 0) {
     return;
   }
 
-  for (++iter; iter != m_SortedEntries.end(); ++iter) {
-    if (resourcePath.size() > iter->first.size())
-      break;
-    if (iter->first.compare(0, resourcePath.size(), resourcePath) == 0) {
-      std::size_t pos = iter->first.find_first_of('/', resourcePath.size());
-      if (pos == std::string::npos || pos == iter->first.size() - 1) {
-        if (relativePaths) {
-          names.push_back(iter->first.substr(resourcePath.size()));
-        } else {
-          names.push_back(iter->first);
-        }
-        indices.push_back(iter->second);
-      }
-    }
+  const PathEntry& dir = m_Entries[static_cast<std::size_t>(entry)];
+  const std::size_t prefix = relativePaths ? dir.nameLength : 0;
+  names.reserve(names.size() + dir.numChildren);
+  indices.reserve(indices.size() + dir.numChildren);
+  for (uint32_t i = dir.firstChild, e = dir.firstChild + dir.numChildren;
+       i < e;
+       ++i) {
+    const PathEntry& child = m_Entries[m_Children[i]];
+    names.emplace_back(
+      m_Names, child.nameOffset + prefix, child.nameLength - prefix);
+    indices.push_back(static_cast<uint32_t>(child.index));
   }
 }
 
@@ -167,18 +349,46 @@ void BundleResourceContainer::FindNodes(
   bool recurse,
   std::vector<BundleResource>& resources) const
 {
-  std::vector<std::string> names;
-  std::vector<uint32_t> indices;
+  int32_t entry = FindEntry(path, true);
+  if (entry < 0) {
+    return;
+  }
 
-  this->GetChildren(path, true, names, indices);
+  // The pattern "*" matches everything and needs no tokens.
+  std::vector<std::string> patternTokens;
+  if (filePattern != "*") {
+    std::stringstream ss(filePattern);
+    std::string tok;
+    while (std::getline(ss, tok, '*')) {
+      patternTokens.push_back(tok);
+    }
+  }
+  this->FindNodes(archive,
+                  m_Entries[static_cast<std::size_t>(entry)],
+                  patternTokens,
+                  recurse,
+                  resources);
+}
 
-  for (std::size_t i = 0, s = names.size(); i < s; ++i) {
-    if (*names[i].rbegin() == '/' && recurse) {
-      this->FindNodes(
-        archive, path + names[i], filePattern, recurse, resources);
+void BundleResourceContainer::FindNodes(
+  const std::shared_ptr<const BundleArchive>& archive,
+  const PathEntry& dir,
+  const std::vector<std::string>& patternTokens,
+  bool recurse,
+  std::vector<BundleResource>& resources) const
+{
+  for (uint32_t i = dir.firstChild, e = dir.firstChild + dir.numChildren;
+       i < e;
+       ++i) {
+    const PathEntry& child = m_Entries[m_Children[i]];
+    // The child's name relative to dir
+    const char* first = m_Names.data() + child.nameOffset + dir.nameLength;
+    const char* last = m_Names.data() + child.nameOffset + child.nameLength;
+    if (recurse && *(last - 1) == '/') {
+      this->FindNodes(archive, child, patternTokens, recurse, resources);
     }
-    if (this->Matches(names[i], filePattern)) {
-      resources.push_back(BundleResource(indices[i], archive));
+    if (Matches(first, last, patternTokens)) {
+      resources.push_back(BundleResource(child.index, archive));
     }
   }
 }
@@ -199,12 +409,32 @@ void BundleResourceContainer::InitMiniz()
                     << ex.what();
   }
 
-  if (!rawBundleResourceData || 
-    !rawBundleResourceData->GetData() ||
-    !mz_zip_reader_init_mem(&m_ZipArchive, rawBundleResourceData->GetData(), rawBundleResourceData->GetSize(), 0)) {
-    if (!mz_zip_reader_init_file(&m_ZipArchive, m_Location.c_str(), 0)) {
-      throw std::runtime_error("Could not init zip archive for bundle at " + m_Location);
-    }
+  if (rawBundleResourceData && rawBundleResourceData->GetData() &&
+      mz_zip_reader_init_mem(&m_ZipArchive,
+                             rawBundleResourceData->GetData(),
+                             rawBundleResourceData->GetSize(),
+                             0)) {
+    // The object file owns the mapping of the resource data.
+    m_MappedData = std::shared_ptr<const char>(
+      m_ObjFile,
+      static_cast<const char*>(rawBundleResourceData->GetData()));
+    return;
+  }
+
+#if defined(US_PLATFORM_APPLE) || defined(US_PLATFORM_POSIX)
+  // Zip files and appended resources are mapped as a whole; miniz
+  // locates the archive at the end of the mapping.
+  std::size_t size = 0;
+  auto mapped = MapFile(m_Location, size);
+  if (mapped && mz_zip_reader_init_mem(&m_ZipArchive, mapped.get(), size, 0)) {
+    m_MappedData = std::move(mapped);
+    return;
+  }
+#endif
+
+  if (!mz_zip_reader_init_file(&m_ZipArchive, m_Location.c_str(), 0)) {
+    throw std::runtime_error("Could not init zip archive for bundle at " +
+                             m_Location);
   }
 }
 
@@ -212,6 +442,8 @@ void BundleResourceContainer::InitSortedEntries()
 {
   mz_uint numFiles =
     mz_zip_reader_get_num_files(const_cast<mz_zip_archive*>(&m_ZipArchive));
+  std::vector<std::pair<std::string, int>> files;
+  files.reserve(numFiles);
   for (mz_uint fileIndex = 0; fileIndex < numFiles; ++fileIndex) {
     char fileName[MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE];
     if (mz_zip_reader_get_filename(&m_ZipArchive,
@@ -219,32 +451,115 @@ void BundleResourceContainer::InitSortedEntries()
                                    fileName,
                                    MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE)) {
       std::string strFileName = fileName;
-      m_SortedEntries.insert(std::make_pair(strFileName, fileIndex));
       std::size_t pos = strFileName.find_first_of('/');
       if (pos != std::string::npos) {
         m_SortedToplevelDirs.insert(strFileName.substr(0, pos));
       }
+      files.emplace_back(std::move(strFileName), static_cast<int>(fileIndex));
+    }
+  }
+
+  // For duplicate names, the first entry in the archive wins.
+  std::stable_sort(files.begin(), files.end(), [](auto& f1, auto& f2) {
+    return f1.first < f2.first;
+  });
+  files.erase(
+    std::unique(files.begin(),
+                files.end(),
+                [](auto& f1, auto& f2) { return f1.first == f2.first; }),
+    files.end());
+
+  const std::size_t n = files.size();
+  std::size_t namesSize = 0;
+  for (auto const& f : files) {
+    namesSize += f.first.size();
+  }
+  m_Names.reserve(namesSize);
+  m_Entries.resize(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    PathEntry& entry = m_Entries[i];
+    entry.nameOffset = static_cast<uint32_t>(m_Names.size());
+    entry.nameLength = static_cast<uint32_t>(files[i].first.size());
+    entry.index = files[i].second;
+    entry.firstChild = 0;
+    entry.numChildren = 0;
+    m_Names += files[i].first;
+  }
+
+  std::size_t slots = 2;
+  while (slots < 2 * n) {
+    slots *= 2;
+  }
+  m_PathIndex.assign(slots, -1);
+  const std::size_t mask = slots - 1;
+  for (std::size_t i = 0; i < n; ++i) {
+    std::size_t slot =
+      CaseFoldedHash(files[i].first.data(), files[i].first.size()) & mask;
+    while (m_PathIndex[slot] != -1) {
+      slot = (slot + 1) & mask;
+    }
+    m_PathIndex[slot] = static_cast<int32_t>(i);
+  }
+
+  // The parent of an entry is the entry named like its path up to and
+  // including the last '/', not counting a trailing one. Entries whose
+  // parent is not in the archive are not listed as anyone's child.
+  std::vector<int32_t> parents(n, -1);
+  for (std::size_t i = 0; i < n; ++i) {
+    const std::string& name = files[i].first;
+    if (name.size() < 2) {
+      continue;
+    }
+    std::size_t pos = name.find_last_of('/', name.size() - 2);
+    if (pos != std::string::npos) {
+      parents[i] = FindEntry(name.substr(0, pos + 1), true);
+      if (parents[i] >= 0) {
+        ++m_Entries[static_cast<std::size_t>(parents[i])].numChildren;
+      }
+    }
+  }
+  uint32_t firstChild = 0;
+  for (auto& entry : m_Entries) {
+    entry.firstChild = firstChild;
+    firstChild += entry.numChildren;
+    entry.numChildren = 0;
+  }
+  // Entries are visited in sorted order, so each range stays sorted.
+  m_Children.resize(firstChild);
+  for (std::size_t i = 0; i < n; ++i) {
+    if (parents[i] >= 0) {
+      PathEntry& parent = m_Entries[static_cast<std::size_t>(parents[i])];
+      m_Children[parent.firstChild + parent.numChildren++] =
+        static_cast<uint32_t>(i);
     }
   }
 }
 
-bool BundleResourceContainer::Matches(const std::string& name,
-                                      const std::string& filePattern) const
+int32_t BundleResourceContainer::FindEntry(const std::string& name,
+                                           bool caseSensitive) const
 {
-  // short-cut
-  if (filePattern == "*")
-    return true;
-
-  std::stringstream ss(filePattern);
-  std::string tok;
-  std::size_t pos = 0;
-  while (std::getline(ss, tok, '*')) {
-    std::size_t index = name.find(tok, pos);
-    if (index == std::string::npos)
-      return false;
-    pos = index + tok.size();
+  if (m_PathIndex.empty()) {
+    return -1;
   }
-  return true;
+  const std::size_t mask = m_PathIndex.size() - 1;
+  std::size_t slot = CaseFoldedHash(name.data(), name.size()) & mask;
+  int32_t caseInsensitiveMatch = -1;
+  for (; m_PathIndex[slot] != -1; slot = (slot + 1) & mask) {
+    const int32_t i = m_PathIndex[slot];
+    const PathEntry& entry = m_Entries[static_cast<std::size_t>(i)];
+    if (entry.nameLength != name.size()) {
+      continue;
+    }
+    const char* entryName = m_Names.data() + entry.nameOffset;
+    if (name.compare(0, name.size(), entryName, entry.nameLength) == 0) {
+      return i;
+    }
+    if (!caseSensitive && caseInsensitiveMatch < 0 &&
+        EqualsCaseInsensitive(entryName, name.data(), name.size())) {
+      caseInsensitiveMatch = i;
+    }
+  }
+  return caseInsensitiveMatch;
 }
 
 void BundleResourceContainer::OpenContainer()
@@ -261,6 +576,7 @@ void BundleResourceContainer::CloseContainer()
   std::lock_guard<std::mutex> lock(m_ZipFileMutex);
   if(m_IsContainerOpen) {
     mz_zip_reader_end(&m_ZipArchive);
+    m_MappedData.reset();
     m_ObjFile.reset();
     m_IsContainerOpen = false;
   }
@@ -71,11 +71,27 @@ public:
 
   std::vector<std::string> GetTopLevelDirs() const;
 
+  /// Return the libraries which the bundle library links against, or an
+  /// empty vector if the location is not a shared library.
+  std::vector<std::string> GetDependencies() const;
+
   bool GetStat(Stat& stat);
   bool GetStat(int index, Stat& stat);
 
   std::unique_ptr<void, void (*)(void*)> GetData(int index);
 
+  /// Return a pointer into the memory mapped zip archive to the data of
+  /// an entry which is stored without compression. The pointer keeps the
+  /// mapping alive. Returns null if the entry is compressed or the archive
+  /// is not memory mapped.
+  std::shared_ptr<const char> GetStoredData(int index);
+
+  /// Return a pointer into the memory mapped zip archive to the raw
+  /// deflate stream of a compressed entry. The pointer keeps the mapping
+  /// alive. Returns null if the entry is not deflated or the archive is
+  /// not memory mapped.
+  std::shared_ptr<const char> GetDeflatedData(int index);
+
   void GetChildren(const std::string& resourcePath,
                    bool relativePaths,
                    std::vector<std::string>& names,
@@ -94,20 +110,46 @@ public:
   void CloseContainer();
 
 private:
-using NameIndexPair = std::pair<std::string, int>;
+  /// Location of an entry's data in the memory mapped zip archive.
+  struct MappedEntry
+  {
+    std::shared_ptr<const char> archive; // keeps the mapping alive
+    const char* data;
+    mz_uint64 compressedSize;
+    mz_uint64 uncompressedSize;
+    mz_uint32 crc32;
+    mz_uint16 method;
+  };
+
+  /// Locate the data of the entry at index in the memory mapped zip
+  /// archive, reading the central directory and local header only.
+  /// Returns false if the archive is not memory mapped or the entry is
+  /// invalid. The data can be read without holding any lock.
+  bool GetMappedEntry(int index, MappedEntry& entry);
 
-  struct PairComp
+  /// An entry of the path index. Entries are sorted by name and the
+  /// children of a directory entry are a contiguous range in m_Children.
+  struct PathEntry
   {
-    inline bool operator()(const NameIndexPair& p1,
-                           const NameIndexPair& p2) const
-    {
-      return p1.first < p2.first;
-    }
+    uint32_t nameOffset; // into m_Names
+    uint32_t nameLength;
+    int index;           // zip file index
+    uint32_t firstChild; // into m_Children
+    uint32_t numChildren;
   };
 
   void InitSortedEntries();
 
-  bool Matches(const std::string& name, const std::string& filePattern) const;
+  /// Return the position of the entry with the given name in m_Entries,
+  /// or -1 if there is none. Case-insensitive lookups prefer an entry
+  /// whose name matches exactly, like miniz does for sorted archives.
+  int32_t FindEntry(const std::string& name, bool caseSensitive) const;
+
+  void FindNodes(const std::shared_ptr<const BundleArchive>& archive,
+                 const PathEntry& dir,
+                 const std::vector<std::string>& patternTokens,
+                 bool recurse,
+                 std::vector<BundleResource>& resources) const;
 
   /// Initialize miniz with the resource zip file information.
   /// throws std::runtime_error if the underlying zip file cannot be opened or read.
@@ -120,14 +162,28 @@ using NameIndexPair = std::pair<std::string, int>;
 
   const std::string m_Location;
   mz_zip_archive m_ZipArchive;
-  std::unique_ptr<BundleObjFile> m_ObjFile;
-
-  std::set<NameIndexPair, PairComp> m_SortedEntries;
+  std::shared_ptr<BundleObjFile> m_ObjFile;
+
+  // The memory miniz reads the zip archive from, or null if miniz reads
+  // from the file. Owns (or shares the owner of) the underlying mapping.
+  std::shared_ptr<const char> m_MappedData;
+  std::vector<std::string> m_Dependencies;
+
+  // The names of all entries, concatenated in sorted order.
+  std::string m_Names;
+  std::vector<PathEntry> m_Entries;
+  // Positions in m_Entries, grouped by parent directory.
+  std::vector<uint32_t> m_Children;
+  // Open-addressing hash index over the case-folded names. Each slot
+  // holds a position in m_Entries or -1 for an empty slot. The size is
+  // a power of two and at least twice the number of entries.
+  std::vector<int32_t> m_PathIndex;
   std::set<std::string> m_SortedToplevelDirs;
 
   // This is used to synchronize miniz file stream API calls.
   // Working with file streams is stateful (e.g. current read position)
-  // and hence not thread-safe.
+  // and hence not thread-safe. Entries of memory mapped archives are
+  // extracted without it.
   mutable std::mutex m_ZipFileStreamMutex;
 
   // Synchronize opening/closing the underlying zip file. Only one thread
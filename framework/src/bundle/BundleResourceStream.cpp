@@ -31,9 +31,7 @@ namespace cppmicroservices {
 
 BundleResourceStream::BundleResourceStream(const BundleResource& resource,
                                            std::ios_base::openmode mode)
-  : BundleResourceBuffer(resource.GetData(),
-                         resource.GetSize(),
-                         mode | std::ios_base::in)
+  : BundleResourceBuffer(resource, mode | std::ios_base::in)
   , std::istream(this)
 {}
 }
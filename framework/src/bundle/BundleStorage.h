@@ -32,6 +32,7 @@
 namespace cppmicroservices {
 
 struct BundleArchive;
+class BundleResourceCache;
 
 /**
  * Interface for managing all bundles library content.
@@ -92,6 +93,23 @@ private:
    * @return true if element was removed.
    */
   virtual bool RemoveArchive(const BundleArchive* ba) = 0;
+
+  /**
+   * Persist changes of the data of a bundle archive.
+   *
+   * @param ba Bundle archive whose data changed.
+   */
+  virtual void UpdateArchive(const BundleArchive* ba) = 0;
+
+  /**
+   * Open the resource container of a bundle archive which was restored
+   * without one.
+   *
+   * @param location Location of the bundle library.
+   * @return The resource container for the location.
+   */
+  virtual std::shared_ptr<BundleResourceContainer> OpenResourceContainer(
+    const std::string& location) = 0;
 };
 }
 
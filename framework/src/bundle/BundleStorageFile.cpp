@@ -22,8 +22,23 @@
 
 #include "BundleStorageFile.h"
 
+#include "cppmicroservices/BundleResource.h"
+#include "cppmicroservices/BundleResourceStream.h"
+#include "cppmicroservices/Constants.h"
+#include "cppmicroservices/GlobalConfig.h"
+#include "cppmicroservices/util/FileSystem.h"
+
+#if defined(US_PLATFORM_APPLE) || defined(US_PLATFORM_POSIX)
+#  include <string>
+#  include "cppmicroservices/util/MappedFile.h"
+#endif
+
 #include "BundleArchive.h"
+#include "BundleResourceContainer.h"
 
+#include <chrono>
+#include <cstring>
+#include <iterator>
 #include <stdexcept>
 
 namespace cppmicroservices {
@@ -33,54 +48,438 @@ static const std::size_t MAX_LOCATION_LEN = 256;
 
 struct ExtraData
 {
-  int32_t loc_index; // -1 -> use location field
+  int32_t loc_index; // -1 -> use location field, otherwise the length of
+                     // the location stored after the manifest
   char location[MAX_LOCATION_LEN];
 };
 
+//! Position of the resource prefix and manifest in the headers file.
+struct CachedHeaders
+{
+  int64_t offset;
+  int32_t prefixLength;
+  int32_t manifestLength;
+};
+
 struct PeristentData
 {
   BundleArchive::Data data;
+  CachedHeaders headers;
   char reserved[MAX_ARCHIVE_SIZE - sizeof(BundleArchive::Data) -
-                sizeof(ExtraData)];
+                sizeof(CachedHeaders) - sizeof(ExtraData)];
   ExtraData extra;
 };
 
-BundleStorageFile::BundleStorageFile()
+struct PersistentHeader
+{
+  char magic[8];
+  int64_t nextFreeId;
+  char reserved[MAX_ARCHIVE_SIZE - 8 - sizeof(int64_t)];
+};
+
+static_assert(sizeof(PeristentData) == MAX_ARCHIVE_SIZE,
+              "Bundle archive records must have a fixed size");
+static_assert(sizeof(PersistentHeader) == MAX_ARCHIVE_SIZE,
+              "The storage header must have the size of a record");
+
+namespace {
+
+const char STORAGE_MAGIC[8] = { 'U', 'S', 'B', 'U', 'N', 'D', 'L', '1' };
+
+std::streamoff RecordOffset(std::int64_t slot)
+{
+  return static_cast<std::streamoff>((slot + 1) * MAX_ARCHIVE_SIZE);
+}
+
+std::size_t FileSize(const std::string& path)
+{
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  return file ? static_cast<std::size_t>(file.tellg()) : 0;
+}
+
+/**
+ * Read-only view of a whole file, which is memory-mapped where supported.
+ */
+class FileContents
+{
+public:
+  explicit FileContents(const std::string& path)
+    : data(nullptr)
+    , size(FileSize(path))
+  {
+    if (size == 0) {
+      return;
+    }
+#if defined(US_PLATFORM_APPLE) || defined(US_PLATFORM_POSIX)
+    mapping.reset(new MappedFile(path, size, 0));
+    data = static_cast<const char*>(mapping->GetMappedAddress());
+    if (data == nullptr) {
+      size = 0;
+    }
+#else
+    std::ifstream file(path, std::ios::binary);
+    buffer.assign(std::istreambuf_iterator<char>(file),
+                  std::istreambuf_iterator<char>());
+    data = buffer.data();
+    size = buffer.size();
+#endif
+  }
+
+  const char* data;
+  std::size_t size;
+
+private:
+#if defined(US_PLATFORM_APPLE) || defined(US_PLATFORM_POSIX)
+  std::unique_ptr<MappedFile> mapping;
+#else
+  std::string buffer;
+#endif
+};
+
+void OpenFile(std::fstream& file, const std::string& path, bool truncate)
+{
+  if (file.is_open()) {
+    file.close();
+  }
+  if (truncate || !util::Exists(path)) {
+    std::ofstream create(path, std::ios::binary | std::ios::trunc);
+  }
+  file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("Cannot open bundle storage file " + path);
+  }
+}
+
+void Write(std::fstream& file, std::streamoff pos, const void* data,
+           std::size_t size)
+{
+  file.seekp(pos);
+  file.write(static_cast<const char*>(data),
+             static_cast<std::streamsize>(size));
+  file.flush();
+  if (!file) {
+    throw std::runtime_error("Writing to the bundle storage failed");
+  }
+}
+
+BundleArchive::Data GetData(const BundleArchive& ba)
 {
-  throw std::logic_error("not implemented");
+  return BundleArchive::Data{
+    ba.GetBundleId(),
+    std::chrono::duration_cast<std::chrono::milliseconds>(
+      ba.GetLastModified().time_since_epoch())
+      .count(),
+    ba.GetAutostartSetting()
+  };
+}
+
+std::string ReadManifest(const BundleArchive& ba)
+{
+  std::string manifest;
+  auto res = ba.GetResource("/manifest.json");
+  if (res) {
+    BundleResourceStream stream(res);
+    manifest.assign(std::istreambuf_iterator<char>(stream),
+                    std::istreambuf_iterator<char>());
+  }
+  return manifest;
+}
+}
+
+BundleStorageFile::BundleStorageFile(
+  const std::string& path,
+  bool clean,
+  std::shared_ptr<BundleResourceCache> resourceCache)
+  : resourceCache(std::move(resourceCache))
+  , archivesPath(path + util::DIR_SEP + "archives")
+  , headersPath(path + util::DIR_SEP + "headers")
+{
+  archives.nextFreeId = 1;
+  archives.numSlots = 0;
+
+  std::size_t usedHeaderBytes = clean ? 0 : Load();
+
+  // Start from scratch if requested or if the files are invalid, and
+  // reclaim the space of removed archives when it dominates the headers.
+  auto l = archives.Lock();
+  US_UNUSED(l);
+  if (archives.v.empty() || FileSize(headersPath) > 2 * usedHeaderBytes) {
+    Rewrite_unlocked();
+  } else {
+    OpenFile(archives.archivesFile, archivesPath, false);
+    OpenFile(archives.headersFile, headersPath, false);
+  }
+}
+
+std::size_t BundleStorageFile::Load()
+{
+  FileContents records(archivesPath);
+  FileContents headers(headersPath);
+  if (records.size < sizeof(PersistentHeader) ||
+      std::memcmp(records.data, STORAGE_MAGIC, sizeof(STORAGE_MAGIC)) != 0) {
+    return 0;
+  }
+
+  PersistentHeader header;
+  std::memcpy(&header, records.data, sizeof(header));
+
+  std::size_t usedHeaderBytes = 0;
+  auto l = archives.Lock();
+  US_UNUSED(l);
+  archives.nextFreeId = static_cast<long>(header.nextFreeId);
+  archives.numSlots =
+    static_cast<std::int64_t>(records.size / MAX_ARCHIVE_SIZE) - 1;
+  for (std::int64_t slot = 0; slot < archives.numSlots; ++slot) {
+    PeristentData record;
+    std::memcpy(&record, records.data + RecordOffset(slot), sizeof(record));
+
+    const auto& h = record.headers;
+    const int32_t locLength = record.extra.loc_index;
+    const std::size_t length =
+      static_cast<std::size_t>(h.prefixLength) + h.manifestLength +
+      (locLength > 0 ? locLength : 0);
+    if (record.data.bundleId <= 0 || h.offset < 0 || h.prefixLength < 0 ||
+        h.manifestLength < 0 ||
+        static_cast<std::size_t>(h.offset) + length > headers.size) {
+      // Free or corrupt record
+      archives.freeSlots.push_back(slot);
+      continue;
+    }
+
+    const char* p = headers.data + h.offset;
+    std::string prefix(p, h.prefixLength);
+    std::string manifest(p + h.prefixLength, h.manifestLength);
+    std::string location =
+      locLength < 0
+        ? std::string(record.extra.location,
+                      strnlen(record.extra.location, MAX_LOCATION_LEN))
+        : std::string(p + h.prefixLength + h.manifestLength, locLength);
+    usedHeaderBytes += length;
+
+    std::unique_ptr<BundleArchive::Data> data(
+      new BundleArchive::Data(record.data));
+    archives.v[record.data.bundleId] = Entry{
+      std::make_shared<BundleArchive>(this,
+                                      resourceCache,
+                                      std::move(data),
+                                      std::move(prefix),
+                                      std::move(location),
+                                      std::move(manifest)),
+      slot
+    };
+  }
+  return usedHeaderBytes;
+}
+
+void BundleStorageFile::Rewrite_unlocked()
+{
+  OpenFile(archives.archivesFile, archivesPath, true);
+  OpenFile(archives.headersFile, headersPath, true);
+
+  // Write the magic last, so that an interrupted rewrite is detected
+  // when the storage is loaded again.
+  PersistentHeader header;
+  std::memset(&header, 0, sizeof(header));
+  Write(archives.archivesFile, 0, &header, sizeof(header));
+
+  archives.numSlots = 0;
+  archives.freeSlots.clear();
+  for (auto& entry : archives.v) {
+    entry.second.slot = -1;
+    WriteRecord_unlocked(entry.second,
+                         entry.second.archive->GetCachedManifest());
+  }
+  WriteHeader_unlocked();
+}
+
+void BundleStorageFile::WriteHeader_unlocked()
+{
+  PersistentHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, STORAGE_MAGIC, sizeof(STORAGE_MAGIC));
+  header.nextFreeId = archives.nextFreeId;
+  Write(archives.archivesFile, 0, &header, sizeof(header));
+}
+
+void BundleStorageFile::WriteRecord_unlocked(Entry& entry,
+                                             const std::string& manifest)
+{
+  const BundleArchive& ba = *entry.archive;
+  const std::string prefix = ba.GetResourcePrefix();
+  const std::string location = ba.GetBundleLocation();
+
+  PeristentData record;
+  std::memset(&record, 0, sizeof(record));
+  record.data = GetData(ba);
+
+  std::string headers = prefix + manifest;
+  if (location.size() < MAX_LOCATION_LEN) {
+    record.extra.loc_index = -1;
+    std::memcpy(record.extra.location, location.data(), location.size());
+  } else {
+    record.extra.loc_index = static_cast<int32_t>(location.size());
+    headers += location;
+  }
+
+  archives.headersFile.seekp(0, std::ios::end);
+  record.headers.offset = static_cast<int64_t>(archives.headersFile.tellp());
+  record.headers.prefixLength = static_cast<int32_t>(prefix.size());
+  record.headers.manifestLength = static_cast<int32_t>(manifest.size());
+  Write(archives.headersFile,
+        record.headers.offset,
+        headers.data(),
+        headers.size());
+
+  if (archives.freeSlots.empty()) {
+    entry.slot = archives.numSlots++;
+  } else {
+    entry.slot = archives.freeSlots.back();
+    archives.freeSlots.pop_back();
+  }
+  Write(archives.archivesFile,
+        RecordOffset(entry.slot),
+        &record,
+        sizeof(record));
+}
+
+void BundleStorageFile::WriteData_unlocked(const Entry& entry)
+{
+  auto data = GetData(*entry.archive);
+  Write(archives.archivesFile, RecordOffset(entry.slot), &data, sizeof(data));
 }
 
 std::vector<std::shared_ptr<BundleArchive>> BundleStorageFile::InsertBundleLib(
-  const std::string& /*location*/)
+  const std::string& location)
 {
-  throw std::logic_error("not implemented");
+  auto resCont = std::make_shared<BundleResourceContainer>(location);
+  return InsertArchives(resCont, resCont->GetTopLevelDirs());
 }
 
 std::vector<std::shared_ptr<BundleArchive>> BundleStorageFile::InsertArchives(
-  const std::shared_ptr<BundleResourceContainer>& /*resCont*/,
-  const std::vector<std::string>& /*topLevelEntries*/)
+  const std::shared_ptr<BundleResourceContainer>& resCont,
+  const std::vector<std::string>& topLevelEntries)
+{
+  std::vector<std::shared_ptr<BundleArchive>> res;
+  {
+    auto l = archives.Lock();
+    US_UNUSED(l);
+    for (auto const& prefix : topLevelEntries) {
+#ifndef US_BUILD_SHARED_LIBS
+      // The system bundle is already installed
+      if (prefix == Constants::SYSTEM_BUNDLE_SYMBOLICNAME) {
+        continue;
+      }
+#endif
+      auto id = archives.nextFreeId++;
+      auto ts = std::chrono::duration_cast<std::chrono::milliseconds>(
+                  std::chrono::steady_clock::now().time_since_epoch())
+                  .count();
+      std::unique_ptr<BundleArchive::Data> data(
+        new BundleArchive::Data{ id, ts, -1 });
+      auto ba = std::make_shared<BundleArchive>(
+        this, resourceCache, std::move(data), resCont, prefix,
+        resCont->GetLocation());
+      archives.v[id] = Entry{ ba, -1 };
+      res.push_back(ba);
+    }
+  }
+
+  // Read the manifests without holding the lock, since this may
+  // decompress data from the bundle library.
+  std::vector<std::string> manifests;
+  for (auto const& ba : res) {
+    manifests.push_back(ReadManifest(*ba));
+  }
+
+  auto l = archives.Lock();
+  US_UNUSED(l);
+  for (std::size_t i = 0; i < res.size(); ++i) {
+    auto iter = archives.v.find(res[i]->GetBundleId());
+    if (iter != archives.v.end()) {
+      WriteRecord_unlocked(iter->second, manifests[i]);
+    }
+  }
+  WriteHeader_unlocked();
+  return res;
+}
+
+bool BundleStorageFile::RemoveArchive(const BundleArchive* ba)
+{
+  auto l = archives.Lock();
+  US_UNUSED(l);
+  auto iter = archives.v.find(ba->GetBundleId());
+  if (iter == archives.v.end()) {
+    return false;
+  }
+  if (iter->second.slot >= 0) {
+    PeristentData record;
+    std::memset(&record, 0, sizeof(record));
+    Write(archives.archivesFile,
+          RecordOffset(iter->second.slot),
+          &record,
+          sizeof(record));
+    archives.freeSlots.push_back(iter->second.slot);
+  }
+  archives.v.erase(iter);
+  return true;
+}
+
+void BundleStorageFile::UpdateArchive(const BundleArchive* ba)
 {
-  throw std::logic_error("not implemented");
+  auto l = archives.Lock();
+  US_UNUSED(l);
+  auto iter = archives.v.find(ba->GetBundleId());
+  if (iter != archives.v.end() && iter->second.slot >= 0 &&
+      iter->second.archive.get() == ba) {
+    WriteData_unlocked(iter->second);
+  }
 }
 
-bool BundleStorageFile::RemoveArchive(const BundleArchive* /*ba*/)
+std::shared_ptr<BundleResourceContainer>
+BundleStorageFile::OpenResourceContainer(const std::string& location)
 {
-  throw std::logic_error("not implemented");
+  auto l = containers.Lock();
+  US_UNUSED(l);
+  auto& weakCont = containers.v[location];
+  auto resCont = weakCont.lock();
+  if (!resCont) {
+    resCont = std::make_shared<BundleResourceContainer>(location);
+    weakCont = resCont;
+  }
+  return resCont;
 }
 
 std::vector<std::shared_ptr<BundleArchive>>
 BundleStorageFile::GetAllBundleArchives() const
 {
-  throw std::logic_error("not implemented");
+  std::vector<std::shared_ptr<BundleArchive>> res;
+  auto l = archives.Lock();
+  US_UNUSED(l);
+  for (auto const& v : archives.v) {
+    res.emplace_back(v.second.archive);
+  }
+  return res;
 }
 
 std::vector<long> BundleStorageFile::GetStartOnLaunchBundles() const
 {
-  throw std::logic_error("not implemented");
+  std::vector<long> res;
+  auto l = archives.Lock();
+  US_UNUSED(l);
+  for (auto& v : archives.v) {
+    if (v.second.archive->GetAutostartSetting() != -1) {
+      res.emplace_back(v.first);
+    }
+  }
+  return res;
 }
 
 void BundleStorageFile::Close()
 {
-  throw std::logic_error("not implemented");
+  // Not need to lock "archives" here: at this point, the framework
+  // is going down and no other threads can access it.
+  archives.v.clear();
+  archives.archivesFile.close();
+  archives.headersFile.close();
 }
 }
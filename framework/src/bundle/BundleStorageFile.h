@@ -23,15 +23,42 @@
 #ifndef CPPMICROSERVICES_BUNDLESTORAGEFILE_H
 #define CPPMICROSERVICES_BUNDLESTORAGEFILE_H
 
+#include "cppmicroservices/detail/Threads.h"
+
 #include "BundleStorage.h"
 
+#include <fstream>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
 namespace cppmicroservices {
 
+/**
+ * Bundle storage which keeps the installed bundles in two files in the
+ * framework's persistent storage area:
+ *
+ * - "archives" holds a header followed by one fixed-size record per
+ *   bundle with its id, time stamp, autostart setting and location.
+ * - "headers" holds the resource prefix and the manifest of each bundle.
+ *
+ * Restored bundle archives use the cached manifest and open their
+ * resource container only when it is first needed.
+ */
 class BundleStorageFile : public BundleStorage
 {
 
 public:
-  BundleStorageFile();
+  /**
+   * Open the bundle storage in the given directory.
+   *
+   * @param path Directory for the storage files, which must exist.
+   * @param clean Remove all bundles which were stored before.
+   * @param resourceCache The cache for the archives' resources.
+   */
+  BundleStorageFile(const std::string& path,
+                    bool clean,
+                    std::shared_ptr<BundleResourceCache> resourceCache);
 
   std::vector<std::shared_ptr<BundleArchive>> InsertBundleLib(
     const std::string& location);
@@ -42,11 +69,73 @@ public:
 
   bool RemoveArchive(const BundleArchive* ba);
 
+  void UpdateArchive(const BundleArchive* ba);
+
+  std::shared_ptr<BundleResourceContainer> OpenResourceContainer(
+    const std::string& location);
+
   std::vector<std::shared_ptr<BundleArchive>> GetAllBundleArchives() const;
 
   std::vector<long> GetStartOnLaunchBundles() const;
 
   void Close();
+
+private:
+  struct Entry
+  {
+    std::shared_ptr<BundleArchive> archive;
+
+    //! Index of the record in the archives file, -1 if not yet written.
+    std::int64_t slot;
+  };
+
+  /**
+   * Restore the archives from the storage files.
+   *
+   * @return The number of bytes in the headers file which are used by
+   *         the restored archives.
+   */
+  std::size_t Load();
+
+  /**
+   * Rewrite both storage files with the current archives, dropping the
+   * data of removed archives.
+   */
+  void Rewrite_unlocked();
+
+  void WriteHeader_unlocked();
+
+  void WriteRecord_unlocked(Entry& entry, const std::string& manifest);
+
+  void WriteData_unlocked(const Entry& entry);
+
+  const std::shared_ptr<BundleResourceCache> resourceCache;
+
+  const std::string archivesPath;
+  const std::string headersPath;
+
+  /**
+   * Bundle id sorted list of all active bundle archives and the files
+   * storing them.
+   */
+  struct : detail::MultiThreaded<>
+  {
+    std::map<long, Entry> v;
+    long nextFreeId;
+    std::int64_t numSlots;
+    std::vector<std::int64_t> freeSlots;
+    std::fstream archivesFile;
+    std::fstream headersFile;
+  } archives;
+
+  /**
+   * Resource containers shared by the restored archives of a location.
+   */
+  struct : detail::MultiThreaded<>
+  {
+    std::unordered_map<std::string, std::weak_ptr<BundleResourceContainer>>
+      v;
+  } containers;
 };
 }
 
@@ -31,8 +31,10 @@
 
 namespace cppmicroservices {
 
-BundleStorageMemory::BundleStorageMemory()
-  : nextFreeId(1)
+BundleStorageMemory::BundleStorageMemory(
+  std::shared_ptr<BundleResourceCache> resourceCache)
+  : resourceCache(std::move(resourceCache))
+  , nextFreeId(1)
 {}
 
 std::vector<std::shared_ptr<BundleArchive>>
@@ -61,6 +63,7 @@ std::vector<std::shared_ptr<BundleArchive>> BundleStorageMemory::InsertArchives(
     std::unique_ptr<BundleArchive::Data> data(new BundleArchive::Data{ id, ts, -1 });
     auto p = archives.v.insert(std::make_pair(id,
                                               std::make_shared<BundleArchive>(this,
+                                                                              resourceCache,
                                                                               std::move(data),
                                                                               resCont,
                                                                               prefix,
@@ -82,6 +85,19 @@ bool BundleStorageMemory::RemoveArchive(const BundleArchive* ba)
   return false;
 }
 
+void BundleStorageMemory::UpdateArchive(const BundleArchive* /*ba*/)
+{
+  // Nothing to persist
+}
+
+std::shared_ptr<BundleResourceContainer>
+BundleStorageMemory::OpenResourceContainer(const std::string& location)
+{
+  // Archives in memory are always created with their resource container,
+  // so this is only a fallback.
+  return std::make_shared<BundleResourceContainer>(location);
+}
+
 std::vector<std::shared_ptr<BundleArchive>>
 BundleStorageMemory::GetAllBundleArchives() const
 {
@@ -36,7 +36,8 @@ class BundleStorageMemory : public BundleStorage
 {
 
 public:
-  BundleStorageMemory();
+  explicit BundleStorageMemory(
+    std::shared_ptr<BundleResourceCache> resourceCache);
 
   std::vector<std::shared_ptr<BundleArchive>> InsertBundleLib(
     const std::string& location);
@@ -47,6 +48,11 @@ public:
 
   bool RemoveArchive(const BundleArchive* ba);
 
+  void UpdateArchive(const BundleArchive* ba);
+
+  std::shared_ptr<BundleResourceContainer> OpenResourceContainer(
+    const std::string& location);
+
   std::vector<std::shared_ptr<BundleArchive>> GetAllBundleArchives() const;
 
   std::vector<long> GetStartOnLaunchBundles() const;
@@ -54,6 +60,8 @@ public:
   void Close();
 
 private:
+  const std::shared_ptr<BundleResourceCache> resourceCache;
+
   /**
    * Next available bundle id.
    */
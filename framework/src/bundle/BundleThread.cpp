@@ -47,6 +47,8 @@ BundleThread::BundleThread(CoreBundleContext* ctx)
   , startStopTimeout(0)
   , op()
   , doRun(true)
+  , isIdle(false)
+  , idlePos()
 {
   th.v = std::thread(&BundleThread::Run, this, ctx);
 }
@@ -104,18 +106,17 @@ void BundleThread::Run(CoreBundleContext* fwCtx)
       // an operation being queued. However, in the mean time, some
       // other thread may have picked this thread from the bundleThreads.value
       // list and calling StartAndWait(). So we only terminate this thread
-      // (by returning) if it was not taken from the bundleThreads list to
-      // do more work. Otherwise, we just keep running for another keep alive
-      // cycle.
+      // (by returning) if it is still idle and there are more idle threads
+      // than the framework keeps alive. Otherwise, we just keep running for
+      // another keep alive cycle.
       {
         auto l2 = fwCtx->bundleThreads.Lock();
         US_UNUSED(l2);
-        auto iter = std::find(fwCtx->bundleThreads.value.begin(),
-                              fwCtx->bundleThreads.value.end(),
-                              this->shared_from_this());
-        if (iter != fwCtx->bundleThreads.value.end()) {
-          fwCtx->bundleThreads.zombies.push_back(*iter);
-          fwCtx->bundleThreads.value.erase(iter);
+        if (isIdle &&
+            fwCtx->bundleThreads.value.size() > fwCtx->bundleThreads.maxIdle) {
+          fwCtx->bundleThreads.zombies.push_back(*idlePos);
+          fwCtx->bundleThreads.value.erase(idlePos);
+          isIdle = false;
           return;
         }
       }
@@ -267,8 +268,14 @@ std::exception_ptr BundleThread::StartAndWait(BundlePrivate* b,
       std::runtime_error("Bundle#" + util::ToString(b->id) + " " + opType +
                          " failed with reason: " + reason));
   } else {
-    b->coreCtx->bundleThreads.Lock(),
-      b->coreCtx->bundleThreads.value.push_front(this->shared_from_this());
+    {
+      auto l = b->coreCtx->bundleThreads.Lock();
+      US_UNUSED(l);
+      auto& idleThreads = b->coreCtx->bundleThreads.value;
+      idleThreads.push_front(this->shared_from_this());
+      idlePos = idleThreads.begin();
+      isIdle = true;
+    }
     if (operation != op.operation) {
       // TODO! Handle when operation has changed.
       // i.e. uninstall during operation?
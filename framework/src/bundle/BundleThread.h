@@ -31,6 +31,7 @@
 
 #include <atomic>
 #include <chrono>
+#include <list>
 #include <string>
 
 #ifdef US_ENABLE_THREADING_SUPPORT
@@ -45,6 +46,9 @@ class CoreBundleContext;
 
 class BundleThread : public std::enable_shared_from_this<BundleThread>
 {
+  friend class BundlePrivate;
+  friend class CoreBundleContext;
+
   const static int OP_IDLE;
   const static int OP_BUNDLE_EVENT;
   const static int OP_START;
@@ -72,6 +76,14 @@ class BundleThread : public std::enable_shared_from_this<BundleThread>
 
   std::atomic<bool> doRun;
 
+  /**
+   * Whether this thread is in the list of idle bundle threads and its
+   * position in the list. Protected by the bundleThreads lock of the
+   * CoreBundleContext.
+   */
+  bool isIdle;
+  std::list<std::shared_ptr<BundleThread>>::iterator idlePos;
+
   struct : detail::MultiThreaded<>
   {
     std::thread v;
@@ -39,6 +39,7 @@ const std::string BUNDLE_VERSION = "bundle.version";
 const std::string BUNDLE_DOCURL = "bundle.doc_url";
 const std::string BUNDLE_CONTACTADDRESS = "bundle.contact_address";
 const std::string BUNDLE_SYMBOLICNAME = "bundle.symbolic_name";
+const std::string BUNDLE_REQUIRES = "bundle.requires";
 const std::string BUNDLE_MANIFESTVERSION = "bundle.manifest_version";
 const std::string BUNDLE_ACTIVATIONPOLICY = "bundle.activation_policy";
 const std::string ACTIVATION_LAZY = "lazy";
@@ -48,11 +49,35 @@ const std::string FRAMEWORK_STORAGE = "org.cppmicroservices.framework.storage";
 const std::string FRAMEWORK_STORAGE_CLEAN =
   "org.cppmicroservices.framework.storage.clean";
 const std::string FRAMEWORK_STORAGE_CLEAN_ONFIRSTINIT = "onFirstInit";
+const std::string FRAMEWORK_STORAGE_TYPE =
+  "org.cppmicroservices.framework.storage.type";
+const std::string FRAMEWORK_STORAGE_TYPE_MEMORY = "memory";
+const std::string FRAMEWORK_STORAGE_TYPE_FILE = "file";
 const std::string FRAMEWORK_THREADING_SUPPORT =
   "org.cppmicroservices.framework.threading.support";
 const std::string FRAMEWORK_THREADING_SINGLE = "single";
 const std::string FRAMEWORK_THREADING_MULTI = "multi";
 const std::string FRAMEWORK_LOG = "org.cppmicroservices.framework.log";
+const std::string FRAMEWORK_BUNDLE_THREADS =
+  "org.cppmicroservices.framework.bundle.threads";
+const std::string FRAMEWORK_EVENT_DELIVERY =
+  "org.cppmicroservices.framework.event.delivery";
+const std::string FRAMEWORK_EVENT_DELIVERY_SYNC = "sync";
+const std::string FRAMEWORK_EVENT_DELIVERY_ASYNC = "async";
+const std::string FRAMEWORK_EVENT_QUEUE_LIMIT =
+  "org.cppmicroservices.framework.event.queue.limit";
+const std::string FRAMEWORK_EVENT_QUEUE_DEPTH =
+  "org.cppmicroservices.framework.event.queue.depth";
+const std::string FRAMEWORK_EVENT_QUEUE_MAX_DEPTH =
+  "org.cppmicroservices.framework.event.queue.max_depth";
+const std::string FRAMEWORK_RESOURCE_CACHE_SIZE =
+  "org.cppmicroservices.framework.resource.cache.size";
+const std::string FRAMEWORK_RESOURCE_CACHE_HITS =
+  "org.cppmicroservices.framework.resource.cache.hits";
+const std::string FRAMEWORK_RESOURCE_CACHE_MISSES =
+  "org.cppmicroservices.framework.resource.cache.misses";
+const std::string FRAMEWORK_RESOURCE_CACHE_EVICTIONS =
+  "org.cppmicroservices.framework.resource.cache.evictions";
 const std::string FRAMEWORK_UUID = "org.cppmicroservices.framework.uuid";
 const std::string FRAMEWORK_WORKING_DIR =
   "org.cppmicroservices.framework.working.dir";
@@ -32,13 +32,17 @@ US_MSVC_DISABLE_WARNING(4355)
 #include "cppmicroservices/util/FileSystem.h"
 #include "cppmicroservices/util/String.h"
 
+#include "BundleResourceCache.h"
+#include "BundleStorageFile.h"
 #include "BundleStorageMemory.h"
 #include "BundleThread.h"
 #include "BundleUtils.h"
 #include "FrameworkPrivate.h"
 
+#include <algorithm>
 #include <iomanip>
 #include <memory>
+#include <thread>
 
 #ifdef US_PLATFORM_POSIX
 #include <dlfcn.h>
@@ -55,6 +59,19 @@ std::unordered_map<std::string, Any> InitProperties(std::unordered_map<std::stri
   // Framework internal diagnostic logging is off by default
   configuration.emplace(std::make_pair(Constants::FRAMEWORK_LOG, Any(false)));
 
+  configuration.emplace(std::make_pair(
+    Constants::FRAMEWORK_BUNDLE_THREADS,
+    Any(static_cast<int>(std::max(1u, std::thread::hardware_concurrency())))));
+
+  // Events are delivered on the thread causing them by default
+  configuration.emplace(std::make_pair(Constants::FRAMEWORK_EVENT_DELIVERY,
+                                       Constants::FRAMEWORK_EVENT_DELIVERY_SYNC));
+  configuration.emplace(
+    std::make_pair(Constants::FRAMEWORK_EVENT_QUEUE_LIMIT, Any(1024)));
+
+  configuration.emplace(std::make_pair(
+    Constants::FRAMEWORK_RESOURCE_CACHE_SIZE, Any(4 * 1024 * 1024)));
+
   // Framework::PROP_THREADING_SUPPORT is a read-only property whose value is based off of a compile-time switch.
   // Run-time modification of the property should be ignored as it is irrelevant.
 #ifdef US_ENABLE_THREADING_SUPPORT
@@ -69,6 +86,9 @@ std::unordered_map<std::string, Any> InitProperties(std::unordered_map<std::stri
   configuration.emplace(std::make_pair(Constants::FRAMEWORK_STORAGE,
                                        Any(FWDIR_DEFAULT)));
 
+  configuration.emplace(std::make_pair(Constants::FRAMEWORK_STORAGE_TYPE,
+                                       Constants::FRAMEWORK_STORAGE_TYPE_MEMORY));
+
   configuration[Constants::FRAMEWORK_VERSION] = std::string(CppMicroServices_VERSION_STR);
   configuration[Constants::FRAMEWORK_VENDOR]  = std::string("CppMicroServices");
 
@@ -100,11 +120,24 @@ CoreBundleContext::CoreBundleContext(
     any_cast<bool>(frameworkProperties.at(Constants::FRAMEWORK_LOG));
   std::ostream* diagnosticLogger = (logger) ? logger : &std::clog;
   sink = std::make_shared<detail::LogSink>(diagnosticLogger, enableDiagLog);
+  bundleThreads.maxIdle = static_cast<std::size_t>(std::max(
+    0,
+    any_cast<int>(frameworkProperties.at(Constants::FRAMEWORK_BUNDLE_THREADS))));
+  resourceCache = std::make_shared<BundleResourceCache>(
+    static_cast<std::size_t>(std::max(
+      0,
+      any_cast<int>(
+        frameworkProperties.at(Constants::FRAMEWORK_RESOURCE_CACHE_SIZE)))));
   systemBundle = std::shared_ptr<FrameworkPrivate>(new FrameworkPrivate(this));
   DIAG_LOG(*sink) << "created";
 }
 
-CoreBundleContext::~CoreBundleContext() = default;
+CoreBundleContext::~CoreBundleContext()
+{
+  // Queued event delivery tasks use the registries, which are
+  // destroyed before the listeners.
+  listeners.StopEventDelivery();
+}
 
 std::shared_ptr<CoreBundleContext> CoreBundleContext::shared_from_this() const
 {
@@ -121,12 +154,13 @@ void CoreBundleContext::Init()
   DIAG_LOG(*sink) << "initializing";
   initCount++;
 
+  bool cleanStorage = false;
   auto storageCleanProp =
     frameworkProperties.find(Constants::FRAMEWORK_STORAGE_CLEAN);
   if (firstInit && storageCleanProp != frameworkProperties.end() &&
       storageCleanProp->second ==
         Constants::FRAMEWORK_STORAGE_CLEAN_ONFIRSTINIT) {
-    // DeleteFWDir();
+    cleanStorage = true;
     firstInit = false;
   }
 
@@ -138,8 +172,19 @@ void CoreBundleContext::Init()
 
   frameworkProperties[Constants::FRAMEWORK_UUID] = ss.str();
 
-  // $TODO we only support non-persistent (main memory) storage yet
-  storage = std::make_unique<BundleStorageMemory>();
+  if (any_cast<std::string>(frameworkProperties.at(
+        Constants::FRAMEWORK_STORAGE_TYPE)) ==
+      Constants::FRAMEWORK_STORAGE_TYPE_FILE) {
+    auto path = GetPersistentStoragePath(this, "bundles", /*create=*/true);
+    if (path.empty()) {
+      throw std::runtime_error(
+        "Persistent bundle storage requires a framework storage area");
+    }
+    storage =
+      std::make_unique<BundleStorageFile>(path, cleanStorage, resourceCache);
+  } else {
+    storage = std::make_unique<BundleStorageMemory>(resourceCache);
+  }
   //  if (frameworkProperties[FWProps::READ_ONLY_PROP] == true)
   //  {
   //    dataStorage.clear();
@@ -204,12 +249,16 @@ void CoreBundleContext::Init()
 void CoreBundleContext::Uninit0()
 {
   DIAG_LOG(*sink) << "uninit";
+  listeners.DrainEvents();
   serviceHooks.Close();
   systemBundle->UninitSystemBundle();
 }
 
 void CoreBundleContext::Uninit1()
 {
+  // Deliver the events of stopped bundles and unregistered services
+  // while the registries are intact.
+  listeners.DrainEvents();
   bundleRegistry.Clear();
   services.Clear();
   listeners.Clear();
@@ -226,7 +275,16 @@ void CoreBundleContext::Uninit1()
   // the current list once and not check for new bundle
   // threads again.
   std::list<std::shared_ptr<BundleThread>> threads;
-  bundleThreads.Lock(), std::swap(threads, bundleThreads.value);
+  {
+    auto l = bundleThreads.Lock();
+    US_UNUSED(l);
+    std::swap(threads, bundleThreads.value);
+#ifdef US_ENABLE_THREADING_SUPPORT
+    for (auto& thread : threads) {
+      thread->isIdle = false;
+    }
+#endif
+  }
 
   while (!threads.empty()) {
     // Quit the bundle thread. This joins the bundle thread
@@ -242,6 +300,8 @@ void CoreBundleContext::Uninit1()
 
   dataStorage.clear();
   storage->Close();
+  // Bundle ids of in-memory storage are reused after re-initialization
+  resourceCache->Clear();
 }
 
 std::string CoreBundleContext::GetDataStorage(long id) const
@@ -251,4 +311,21 @@ std::string CoreBundleContext::GetDataStorage(long id) const
   }
   return std::string();
 }
+
+std::unordered_map<std::string, Any> CoreBundleContext::GetRuntimeProperties()
+  const
+{
+  std::unordered_map<std::string, Any> props;
+  props[Constants::FRAMEWORK_EVENT_QUEUE_DEPTH] =
+    static_cast<long>(listeners.GetEventQueueDepth());
+  props[Constants::FRAMEWORK_EVENT_QUEUE_MAX_DEPTH] =
+    static_cast<long>(listeners.GetEventQueueMaxDepth());
+  props[Constants::FRAMEWORK_RESOURCE_CACHE_HITS] =
+    static_cast<long>(resourceCache->Hits());
+  props[Constants::FRAMEWORK_RESOURCE_CACHE_MISSES] =
+    static_cast<long>(resourceCache->Misses());
+  props[Constants::FRAMEWORK_RESOURCE_CACHE_EVICTIONS] =
+    static_cast<long>(resourceCache->Evictions());
+  return props;
+}
 }
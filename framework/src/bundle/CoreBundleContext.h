@@ -70,6 +70,7 @@ public:
 };
 
 struct BundleStorage;
+class BundleResourceCache;
 class BundleThread;
 class FrameworkPrivate;
 
@@ -114,12 +115,15 @@ public:
   Debug debug;
 
   /**
-   * Threads for running listeners and activators
+   * Threads for running listeners and activators. Idle threads are kept
+   * in value, most recently used first. Idle threads beyond maxIdle
+   * terminate after their keep-alive time.
    */
   struct : detail::MultiThreaded<>
   {
     std::list<std::shared_ptr<BundleThread>> value;
     std::list<std::shared_ptr<BundleThread>> zombies;
+    std::size_t maxIdle;
   } bundleThreads;
 
   /**
@@ -127,6 +131,12 @@ public:
    */
   std::unique_ptr<BundleStorage> storage;
 
+  /**
+   * Decompressed resource data of all bundles, shared with the
+   * bundle archives.
+   */
+  std::shared_ptr<BundleResourceCache> resourceCache;
+
   /**
    * Private Bundle Data Storage
    */
@@ -200,6 +210,12 @@ public:
    */
   std::string GetDataStorage(long id) const;
 
+  /**
+   * Get the read-only framework properties whose values change while
+   * the framework is running, like the event queue metrics.
+   */
+  std::unordered_map<std::string, Any> GetRuntimeProperties() const;
+
 private:
   // The core context is exclusively constructed by the FrameworkFactory class
   friend class FrameworkFactory;
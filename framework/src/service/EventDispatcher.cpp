@@ -0,0 +1,280 @@
+/*=============================================================================
+
+  Library: CppMicroServices
+
+  Copyright (c) The CppMicroServices developers. See the COPYRIGHT
+  file at the top-level directory of this distribution and at
+  https://github.com/CppMicroServices/CppMicroServices/COPYRIGHT .
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#include "EventDispatcher.h"
+
+#include <algorithm>
+
+namespace cppmicroservices {
+
+namespace {
+
+/**
+ * Joins the worker threads of dispatchers which were destroyed by one
+ * of their own workers. Each batch of workers is joined by a thread of
+ * its own, which is joined by the thread of the next batch or at exit.
+ */
+class WorkerReaper : private detail::MultiThreaded<>
+{
+public:
+  static WorkerReaper& Instance()
+  {
+    static WorkerReaper reaper;
+    return reaper;
+  }
+
+  ~WorkerReaper()
+  {
+    auto l = this->Lock();
+    US_UNUSED(l);
+    if (last.joinable()) {
+      last.join();
+    }
+  }
+
+  void Join(std::vector<std::thread> threads)
+  {
+    auto l = this->Lock();
+    US_UNUSED(l);
+    last = std::thread(
+      [previous = std::move(last), threads = std::move(threads)]() mutable {
+        for (auto& thread : threads) {
+          thread.join();
+        }
+        if (previous.joinable()) {
+          previous.join();
+        }
+      });
+  }
+
+private:
+  WorkerReaper() = default;
+
+  std::thread last;
+};
+
+//! The state of the dispatcher this thread is a worker of
+thread_local const void* workerState = nullptr;
+
+//! The state of the dispatcher whose task this thread is running
+thread_local const void* taskState = nullptr;
+}
+
+EventDispatcher::State::State(std::size_t queueLimit)
+  : queueLimit(queueLimit)
+  , depth(0)
+  , maxDepth(0)
+  , numRunning(0)
+  , stopped(false)
+{}
+
+EventDispatcher::EventDispatcher(std::size_t numThreads,
+                                 std::size_t queueLimit)
+  : state(std::make_shared<State>(queueLimit))
+{
+  for (std::size_t i = 0; i < numThreads; ++i) {
+    workers.emplace_back(&EventDispatcher::Run, state);
+  }
+}
+
+EventDispatcher::~EventDispatcher()
+{
+  Stop();
+}
+
+void EventDispatcher::Stop()
+{
+  {
+    auto l = state->Lock();
+    US_UNUSED(l);
+    if (state->stopped) {
+      return;
+    }
+    state->stopped = true;
+  }
+  state->NotifyAll();
+
+  if (!IsWorkerThread()) {
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    return;
+  }
+
+  // E.g. a task released the last reference to the framework. Wait for
+  // the other workers to run the remaining tasks. The worker cannot
+  // join itself, so all workers are joined elsewhere. It keeps the
+  // state alive until it returns.
+  {
+    auto l = state->Lock();
+    Drain_unlocked(l);
+  }
+  WorkerReaper::Instance().Join(std::move(workers));
+}
+
+void EventDispatcher::Post(const void* key, Task task)
+{
+  auto l = state->Lock();
+  if (state->stopped) {
+    l.UnLock();
+    task();
+    return;
+  }
+
+  // Waiting on a worker thread could dead-lock, since the full queue
+  // may be the one this worker is draining.
+  if (state->queueLimit > 0 && !IsWorkerThread()) {
+    state->Wait(l, [this, key] {
+      auto iter = state->queues.find(key);
+      return state->stopped || iter == state->queues.end() ||
+             iter->second.tasks.size() < state->queueLimit;
+    });
+  }
+
+  auto& queue = state->queues[key];
+  queue.tasks.push_back(std::move(task));
+  ++state->depth;
+  state->maxDepth = std::max(state->maxDepth, queue.tasks.size());
+  if (!queue.running && queue.tasks.size() == 1) {
+    state->ready.push_back(key);
+  }
+  l.UnLock();
+  state->NotifyAll();
+}
+
+void EventDispatcher::Drain()
+{
+  auto l = state->Lock();
+  Drain_unlocked(l);
+}
+
+void EventDispatcher::Drain_unlocked(
+  detail::MutexLockingStrategy<>::UniqueLock& l)
+{
+  const std::size_t self = IsRunningTask() ? 1 : 0;
+  for (;;) {
+    state->Wait(l, [this, self] {
+      return state->ready.empty() && state->numRunning == self;
+    });
+    if (state->depth == 0) {
+      return;
+    }
+
+    // The other workers are idle, so the queued tasks are those of the
+    // queue whose task this thread is running. No worker picks them up
+    // before that task returns, so run them here.
+    auto iter = std::find_if(
+      state->queues.begin(),
+      state->queues.end(),
+      [](const std::pair<const void* const, Queue>& q) {
+        return q.second.running && !q.second.tasks.empty();
+      });
+    if (iter == state->queues.end()) {
+      return;
+    }
+    Task task = std::move(iter->second.tasks.front());
+    iter->second.tasks.pop_front();
+    --state->depth;
+    l.UnLock();
+    state->NotifyAll();
+    try {
+      task();
+    } catch (...) {
+      // Tasks report listener exceptions themselves
+    }
+    task = nullptr;
+    l.Lock();
+  }
+}
+
+std::size_t EventDispatcher::GetQueueDepth() const
+{
+  return (state->Lock(), state->depth);
+}
+
+std::size_t EventDispatcher::GetMaxQueueDepth() const
+{
+  return (state->Lock(), state->maxDepth);
+}
+
+void EventDispatcher::Run(const std::shared_ptr<State>& state)
+{
+  workerState = state.get();
+  auto l = state->Lock();
+  for (;;) {
+    state->Wait(l, [&state] {
+      return state->stopped || !state->ready.empty();
+    });
+    if (state->ready.empty()) {
+      return;
+    }
+
+    const void* key = state->ready.front();
+    state->ready.pop_front();
+    auto& queue = state->queues[key];
+    Task task = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    queue.running = true;
+    --state->depth;
+    ++state->numRunning;
+    l.UnLock();
+
+    // Room for a waiting producer
+    state->NotifyAll();
+    taskState = state.get();
+    try {
+      task();
+    } catch (...) {
+      // Tasks report listener exceptions themselves
+    }
+    taskState = nullptr;
+
+    l.Lock();
+    --state->numRunning;
+    queue.running = false;
+    if (queue.tasks.empty()) {
+      state->queues.erase(key);
+    } else {
+      state->ready.push_back(key);
+    }
+    l.UnLock();
+    state->NotifyAll();
+
+    // Releasing the objects captured by the task may release the last
+    // reference to the framework and destroy the dispatcher, or shut
+    // the framework down and drain the queues. Neither must wait for
+    // this worker.
+    task = nullptr;
+    l.Lock();
+  }
+}
+
+bool EventDispatcher::IsWorkerThread() const
+{
+  return workerState == state.get();
+}
+
+bool EventDispatcher::IsRunningTask() const
+{
+  return taskState == state.get();
+}
+}
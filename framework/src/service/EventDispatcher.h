@@ -0,0 +1,155 @@
+/*=============================================================================
+
+  Library: CppMicroServices
+
+  Copyright (c) The CppMicroServices developers. See the COPYRIGHT
+  file at the top-level directory of this distribution and at
+  https://github.com/CppMicroServices/CppMicroServices/COPYRIGHT .
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#ifndef CPPMICROSERVICES_EVENTDISPATCHER_H
+#define CPPMICROSERVICES_EVENTDISPATCHER_H
+
+#include "cppmicroservices/detail/Threads.h"
+#include "cppmicroservices/detail/WaitCondition.h"
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace cppmicroservices {
+
+/**
+ * Runs event delivery tasks on a pool of worker threads.
+ *
+ * Tasks are queued per key, e.g. the bundle context owning the
+ * listeners. A queue is drained by at most one worker at a time, so the
+ * tasks of a key run in the order in which they were posted, while
+ * tasks of different keys run concurrently.
+ *
+ * This class is not part of the public API.
+ */
+class EventDispatcher
+{
+public:
+  using Task = std::function<void()>;
+
+  /**
+   * @param numThreads The number of worker threads.
+   * @param queueLimit The maximum number of tasks queued per key, or zero
+   *        if the number of queued tasks is not limited.
+   */
+  EventDispatcher(std::size_t numThreads, std::size_t queueLimit);
+
+  /**
+   * Calls Stop().
+   */
+  ~EventDispatcher();
+
+  /**
+   * Runs all queued tasks and joins the worker threads. Tasks posted
+   * afterwards are run on the posting thread.
+   *
+   * If called from a worker thread, e.g. because a task released the
+   * last reference to the framework, this waits until the other workers
+   * are idle and the worker threads are joined by another thread
+   * instead.
+   */
+  void Stop();
+
+  /**
+   * Queue a task for the given key. If the queue of the key is full,
+   * this waits until it has room again, unless it is called from a
+   * worker thread.
+   */
+  void Post(const void* key, Task task);
+
+  /**
+   * Wait until all queued tasks have been run. If called from a task,
+   * this waits until the other workers are idle and runs the remaining
+   * tasks of the calling task's queue itself.
+   */
+  void Drain();
+
+  /**
+   * The number of queued tasks which have not been started yet.
+   */
+  std::size_t GetQueueDepth() const;
+
+  /**
+   * The largest number of tasks which were queued for a single key.
+   */
+  std::size_t GetMaxQueueDepth() const;
+
+private:
+  struct Queue
+  {
+    Queue()
+      : running(false)
+    {}
+
+    std::deque<Task> tasks;
+
+    //! A worker is running a task of this queue
+    bool running;
+  };
+
+  /**
+   * The queues, shared with the worker threads. A worker may still use
+   * them after the dispatcher was destroyed by one of its tasks.
+   */
+  struct State
+    : detail::MultiThreaded<detail::MutexLockingStrategy<>,
+                            detail::WaitCondition>
+  {
+    explicit State(std::size_t queueLimit);
+
+    const std::size_t queueLimit;
+
+    std::unordered_map<const void*, Queue> queues;
+
+    //! Keys of queues which have tasks and no running worker, in FIFO order
+    std::deque<const void*> ready;
+
+    std::size_t depth;
+    std::size_t maxDepth;
+    std::size_t numRunning;
+    bool stopped;
+  };
+
+  static void Run(const std::shared_ptr<State>& state);
+
+  /**
+   * Wait until all tasks but the one running on this thread, if any,
+   * have been run.
+   */
+  void Drain_unlocked(detail::MutexLockingStrategy<>::UniqueLock& l);
+
+  bool IsWorkerThread() const;
+
+  bool IsRunningTask() const;
+
+  const std::shared_ptr<State> state;
+
+  std::vector<std::thread> workers;
+};
+}
+
+#endif // CPPMICROSERVICES_EVENTDISPATCHER_H
@@ -117,8 +117,7 @@ void ServiceHooks::FilterServiceReferences(
   std::vector<ServiceReferenceBase>& refs)
 {
   std::vector<ServiceRegistrationBase> srl;
-  coreCtx->services.Get_unlocked(us_service_interface_iid<ServiceFindHook>(),
-                                 srl);
+  coreCtx->services.Get(us_service_interface_id<ServiceFindHook>(), srl);
   if (!srl.empty()) {
     ShrinkableVector<ServiceReferenceBase> filtered(refs);
 
@@ -149,18 +148,29 @@ void ServiceHooks::FilterServiceReferences(
   }
 }
 
+bool ServiceHooks::HasServiceEventListenerHooks() const
+{
+  std::vector<ServiceRegistrationBase> eventListenerHooks;
+  coreCtx->services.Get(us_service_interface_id<ServiceEventListenerHook>(),
+                        eventListenerHooks);
+  return !eventListenerHooks.empty();
+}
+
 void ServiceHooks::FilterServiceEventReceivers(
   const ServiceEvent& evt,
+  const ServiceListeners::ServiceListenerEntries& allListeners,
   ServiceListeners::ServiceListenerEntries& receivers)
 {
   std::vector<ServiceRegistrationBase> eventListenerHooks;
-  coreCtx->services.Get(us_service_interface_iid<ServiceEventListenerHook>(),
+  coreCtx->services.Get(us_service_interface_id<ServiceEventListenerHook>(),
                         eventListenerHooks);
-  if (!eventListenerHooks.empty()) {
+  if (eventListenerHooks.empty()) {
+    receivers = allListeners;
+  } else {
     std::sort(eventListenerHooks.begin(), eventListenerHooks.end());
     std::map<BundleContext, std::vector<ServiceListenerHook::ListenerInfo>>
       listeners;
-    for (auto& sle : receivers) {
+    for (auto& sle : allListeners) {
       listeners[sle.GetBundleContext()].push_back(sle);
     }
 
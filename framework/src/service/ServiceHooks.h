@@ -67,8 +67,22 @@ public:
                                const std::string& filter,
                                std::vector<ServiceReferenceBase>& refs);
 
+  /**
+   * Check if any ServiceEventListenerHook service is registered.
+   */
+  bool HasServiceEventListenerHooks() const;
+
+  /**
+   * Call the registered ServiceEventListenerHook services.
+   *
+   * @param evt The service event.
+   * @param allListeners All service listeners.
+   * @param receivers Filled with the listeners which have not been
+   *        removed by a hook.
+   */
   void FilterServiceEventReceivers(
     const ServiceEvent& evt,
+    const ServiceListeners::ServiceListenerEntries& allListeners,
     ServiceListeners::ServiceListenerEntries& receivers);
 
   void HandleServiceListenerReg(const ServiceListenerEntry& sle);
@@ -27,6 +27,7 @@ US_MSVC_PUSH_DISABLE_WARNING(
 
 #include "ServiceListenerEntry.h"
 
+#include "LDAPExprCache.h"
 #include "ServiceListenerHookPrivate.h"
 
 #include <cassert>
@@ -59,7 +60,7 @@ public:
     , hashValue(0)
   {
     if (!filter.empty()) {
-      ldap = LDAPExpr(filter);
+      ldap = LDAPExprCache::Global().Get(filter);
     }
   }
 
@@ -68,25 +69,22 @@ public:
   LDAPExpr ldap;
 
   /**
-   * The elements of "simple" filters are cached, for easy lookup.
+   * The buckets of ServiceListeners containing this entry.
    *
-   * The grammar for simple filters is as follows:
+   * Listeners with "simple" filters are stored in one bucket per
+   * accepted value of the cached keys. The grammar for simple filters
+   * is as follows:
    *
    * <pre>
    * Simple = '(' attr '=' value ')'
    *        | '(' '|' Simple+ ')'
    * </pre>
-   * where <code>attr</code> is one of Constants#OBJECTCLASS,
-   * Constants#SERVICE_ID or Constants#SERVICE_PID, and
-   * <code>value</code> must not contain a wildcard character.
-   * <p>
-   * The index of the vector determines which key the cache is for
-   * (see ServiceListenerState#hashedKeys). For each key, there is
-   * a vector pointing out the values which are accepted by this
-   * ServiceListenerEntry's filter. This cache is maintained to make
-   * it easy to remove this service listener.
+   * where <code>attr</code> is one of Constants#OBJECTCLASS or
+   * Constants#SERVICE_ID, and <code>value</code> must not contain a
+   * wildcard character. All other listeners are stored in a single
+   * bucket which is checked for every event.
    */
-  LDAPExpr::LocalCache local_cache;
+  ServiceListenerEntry::CachePositions cachePositions;
 
   std::size_t hashValue;
 };
@@ -131,9 +129,10 @@ const LDAPExpr& ServiceListenerEntry::GetLDAPExpr() const
   return static_cast<ServiceListenerEntryData*>(d.Data())->ldap;
 }
 
-LDAPExpr::LocalCache& ServiceListenerEntry::GetLocalCache() const
+ServiceListenerEntry::CachePositions& ServiceListenerEntry::GetCachePositions()
+  const
 {
-  return static_cast<ServiceListenerEntryData*>(d.Data())->local_cache;
+  return static_cast<ServiceListenerEntryData*>(d.Data())->cachePositions;
 }
 
 void ServiceListenerEntry::CallDelegate(const ServiceEvent& event) const
@@ -30,6 +30,8 @@
 #include "LDAPExpr.h"
 #include "Utils.h"
 
+#include <vector>
+
 namespace cppmicroservices {
 
 class BundleContextPrivate;
@@ -59,9 +61,22 @@ public:
                        ListenerTokenId tokenId,
                        const std::string& filter = "");
 
+  /**
+   * The position of this entry in one of the listener buckets of
+   * ServiceListeners. Storing it allows removing the entry from a
+   * bucket in constant time.
+   */
+  struct CachePosition
+  {
+    int cacheIx;
+    long key;
+    std::size_t index;
+  };
+  using CachePositions = std::vector<CachePosition>;
+
   const LDAPExpr& GetLDAPExpr() const;
 
-  LDAPExpr::LocalCache& GetLocalCache() const;
+  CachePositions& GetCachePositions() const;
 
   void CallDelegate(const ServiceEvent& event) const;
 
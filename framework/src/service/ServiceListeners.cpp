@@ -27,6 +27,7 @@ US_MSVC_PUSH_DISABLE_WARNING(
 
 #include "ServiceListeners.h"
 
+#include "cppmicroservices/BundleEvent.h"
 #include "cppmicroservices/FrameworkEvent.h"
 #include "cppmicroservices/ListenerFunctors.h"
 #include "cppmicroservices/util/Error.h"
@@ -35,30 +36,55 @@ US_MSVC_PUSH_DISABLE_WARNING(
 #include "BundleContextPrivate.h"
 #include "BundlePrivate.h"
 #include "CoreBundleContext.h"
+#include "InterfaceIdTable.h"
 #include "Properties.h"
 #include "ServiceReferenceBasePrivate.h"
+#include "ServiceRegistrationBasePrivate.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
+#include <thread>
 
 namespace cppmicroservices {
 
 ServiceListeners::ServiceListeners(CoreBundleContext* coreCtx)
   : listenerId(0)
+  , resolvedInterfaceCount(0)
   , coreCtx(coreCtx)
 {
   hashedServiceKeys.push_back(Constants::OBJECTCLASS);
   hashedServiceKeys.push_back(Constants::SERVICE_ID);
+
+#ifdef US_ENABLE_THREADING_SUPPORT
+  auto& props = coreCtx->frameworkProperties;
+  auto delivery = props.find(Constants::FRAMEWORK_EVENT_DELIVERY);
+  if (delivery != props.end() &&
+      any_cast<std::string>(delivery->second) ==
+        Constants::FRAMEWORK_EVENT_DELIVERY_ASYNC) {
+    auto limit = any_cast<int>(props.at(Constants::FRAMEWORK_EVENT_QUEUE_LIMIT));
+    eventDispatcher.reset(new EventDispatcher(
+      std::max(2u, std::thread::hardware_concurrency()),
+      static_cast<std::size_t>(std::max(0, limit))));
+  }
+#endif
 }
 
 void ServiceListeners::Clear()
 {
+  // Deliver the events which are still queued before the listeners
+  // are gone.
+  DrainEvents();
+
   bundleListenerMap.Lock(), bundleListenerMap.value.clear();
   {
     auto l = this->Lock();
     US_UNUSED(l);
     serviceSet.clear();
+    serviceSetSnapshot.reset();
     hashedServiceKeys.clear();
     complicatedListeners.clear();
+    unresolvedListeners.clear();
     cache[0].clear();
     cache[1].clear();
   }
@@ -89,6 +115,7 @@ ListenerToken ServiceListeners::AddServiceListener(
     auto l = this->Lock();
     US_UNUSED(l);
     serviceSet.insert(sle);
+    serviceSetSnapshot.reset();
     CheckSimple_unlocked(sle);
   }
   coreCtx->serviceHooks.HandleServiceListenerReg(sle);
@@ -126,6 +153,7 @@ void ServiceListeners::RemoveServiceListener(
       it->SetRemoved(true);
       RemoveFromCache_unlocked(*it);
       serviceSet.erase(it);
+      serviceSetSnapshot.reset();
     }
   }
   if (!sle.IsNull()) {
@@ -290,20 +318,51 @@ void ServiceListeners::BundleChanged(const BundleEvent& evt)
   coreCtx->bundleHooks.FilterBundleEventReceivers(evt, filteredBundleListeners);
 
   for (auto& bundleListeners : filteredBundleListeners) {
-    for (auto& bundleListener : bundleListeners.second) {
-      try {
-        std::get<0>(bundleListener.second)(evt);
-      } catch (...) {
-        SendFrameworkEvent(FrameworkEvent(
-          FrameworkEvent::Type::FRAMEWORK_ERROR,
-          MakeBundle(bundleListeners.first->bundle->shared_from_this()),
-          std::string("Bundle listener threw an exception"),
-          std::current_exception()));
-      }
+    if (eventDispatcher) {
+      auto context = bundleListeners.first;
+      auto listeners = std::move(bundleListeners.second);
+      eventDispatcher->Post(context.get(), [this, context, listeners, evt] {
+        DeliverBundleEvent(context, listeners, evt);
+      });
+    } else {
+      DeliverBundleEvent(bundleListeners.first, bundleListeners.second, evt);
+    }
+  }
+}
+
+void ServiceListeners::DeliverBundleEvent(
+  const std::shared_ptr<BundleContextPrivate>& context,
+  const std::unordered_map<ListenerTokenId, BundleListenerEntry>& listeners,
+  const BundleEvent& evt)
+{
+  for (auto& bundleListener : listeners) {
+    // The listener may have been removed while the event was queued
+    if (!IsBundleListenerRegistered(context, bundleListener.first)) {
+      continue;
+    }
+    try {
+      std::get<0>(bundleListener.second)(evt);
+    } catch (...) {
+      SendFrameworkEvent(
+        FrameworkEvent(FrameworkEvent::Type::FRAMEWORK_ERROR,
+                       MakeBundle(context->bundle->shared_from_this()),
+                       std::string("Bundle listener threw an exception"),
+                       std::current_exception()));
     }
   }
 }
 
+bool ServiceListeners::IsBundleListenerRegistered(
+  const std::shared_ptr<BundleContextPrivate>& context,
+  ListenerTokenId tokenId) const
+{
+  auto l = bundleListenerMap.Lock();
+  US_UNUSED(l);
+  auto iter = bundleListenerMap.value.find(context);
+  return iter != bundleListenerMap.value.end() &&
+         iter->second.count(tokenId) != 0;
+}
+
 void ServiceListeners::RemoveAllListeners(
   const std::shared_ptr<BundleContextPrivate>& context)
 {
@@ -314,8 +373,10 @@ void ServiceListeners::RemoveAllListeners(
          it != serviceSet.end();) {
 
       if (GetPrivate(it->GetBundleContext()) == context) {
+        it->SetRemoved(true);
         RemoveFromCache_unlocked(*it);
         serviceSet.erase(it++);
+        serviceSetSnapshot.reset();
       } else {
         ++it;
       }
@@ -372,29 +433,76 @@ void ServiceListeners::ServiceChanged(ServiceListenerEntries& receivers,
 
   for (auto& l : receivers) {
     if (!l.IsRemoved()) {
-      try {
-        ++n;
-        l.CallDelegate(evt);
-      } catch (...) {
-        std::string message("Service listener in " +
-                            l.GetBundleContext().GetBundle().GetSymbolicName() +
-                            " threw an exception!");
-        SendFrameworkEvent(FrameworkEvent(FrameworkEvent::Type::FRAMEWORK_ERROR,
-                                          l.GetBundleContext().GetBundle(),
-                                          message,
-                                          std::current_exception()));
+      ++n;
+      if (eventDispatcher) {
+        eventDispatcher->Post(GetPrivate(l.GetBundleContext()).get(),
+                              [this, l, evt] { DeliverServiceEvent(l, evt); });
+      } else {
+        DeliverServiceEvent(l, evt);
       }
     }
   }
 }
 
+void ServiceListeners::DeliverServiceEvent(const ServiceListenerEntry& l,
+                                           const ServiceEvent& evt)
+{
+  // The listener may have been removed while the event was queued
+  if (l.IsRemoved()) {
+    return;
+  }
+  try {
+    l.CallDelegate(evt);
+  } catch (...) {
+    std::string message("Service listener in " +
+                        l.GetBundleContext().GetBundle().GetSymbolicName() +
+                        " threw an exception!");
+    SendFrameworkEvent(FrameworkEvent(FrameworkEvent::Type::FRAMEWORK_ERROR,
+                                      l.GetBundleContext().GetBundle(),
+                                      message,
+                                      std::current_exception()));
+  }
+}
+
+std::size_t ServiceListeners::GetEventQueueDepth() const
+{
+  return eventDispatcher ? eventDispatcher->GetQueueDepth() : 0;
+}
+
+std::size_t ServiceListeners::GetEventQueueMaxDepth() const
+{
+  return eventDispatcher ? eventDispatcher->GetMaxQueueDepth() : 0;
+}
+
+void ServiceListeners::DrainEvents()
+{
+  if (eventDispatcher) {
+    eventDispatcher->Drain();
+  }
+}
+
+void ServiceListeners::StopEventDelivery()
+{
+  if (eventDispatcher) {
+    eventDispatcher->Stop();
+  }
+}
+
 void ServiceListeners::GetMatchingServiceListeners(const ServiceEvent& evt,
                                                    ServiceListenerEntries& set)
 {
-  // Filter the original set of listeners
-  ServiceListenerEntries receivers = (this->Lock(), serviceSet);
-  // This must not be called with any locks held
-  coreCtx->serviceHooks.FilterServiceEventReceivers(evt, receivers);
+  // Service event listener hooks see all listeners and may remove
+  // receivers. Without hooks, neither the set of all listeners is
+  // copied nor visited and the cost depends on the matching listeners.
+  ServiceListenerEntries filteredReceivers;
+  const ServiceListenerEntries* receivers = nullptr;
+  if (coreCtx->serviceHooks.HasServiceEventListenerHooks()) {
+    auto listeners = GetServiceSetSnapshot();
+    // This must not be called with any locks held
+    coreCtx->serviceHooks.FilterServiceEventReceivers(
+      evt, *listeners, filteredReceivers);
+    receivers = &filteredReceivers;
+  }
 
   // Get a copy of the service reference and keep it until we are
   // done with its properties.
@@ -404,9 +512,11 @@ void ServiceListeners::GetMatchingServiceListeners(const ServiceEvent& evt,
   {
     auto l = this->Lock();
     US_UNUSED(l);
+    ResolveListeners_unlocked();
+
     // Check complicated or empty listener filters
     for (auto& sse : complicatedListeners) {
-      if (receivers.count(sse) == 0)
+      if (receivers && receivers->count(sse) == 0)
         continue;
       const LDAPExpr& ldapExpr = sse.GetLDAPExpr();
       if (ldapExpr.IsNull() || ldapExpr.Evaluate(props, false)) {
@@ -415,19 +525,28 @@ void ServiceListeners::GetMatchingServiceListeners(const ServiceEvent& evt,
     }
 
     // Check the cache
-    const auto c = any_cast<std::vector<std::string>>(
-      props->Value_unlocked(Constants::OBJECTCLASS));
-    for (auto& objClass : c) {
-      AddToSet_unlocked(set, receivers, OBJECTCLASS_IX, objClass);
+    for (auto interfaceId : ref.d.load()->registration->interfaceIds) {
+      AddToSet_unlocked(
+        set, receivers, OBJECTCLASS_IX, static_cast<long>(interfaceId));
     }
 
-    auto service_id =
-      any_cast<long>(props->Value_unlocked(Constants::SERVICE_ID));
     AddToSet_unlocked(set,
                       receivers,
                       SERVICE_ID_IX,
-                      cppmicroservices::util::ToString((service_id)));
+                      ref.d.load()->registration->serviceId);
+  }
+}
+
+std::shared_ptr<const ServiceListeners::ServiceListenerEntries>
+ServiceListeners::GetServiceSetSnapshot()
+{
+  auto l = this->Lock();
+  US_UNUSED(l);
+  if (!serviceSetSnapshot) {
+    serviceSetSnapshot =
+      std::make_shared<const ServiceListenerEntries>(serviceSet);
   }
+  return serviceSetSnapshot;
 }
 
 std::vector<ServiceListenerHook::ListenerInfo>
@@ -445,62 +564,129 @@ ServiceListeners::GetListenerInfoCollection() const
 
 void ServiceListeners::RemoveFromCache_unlocked(const ServiceListenerEntry& sle)
 {
-  if (!sle.GetLocalCache().empty()) {
-    for (std::size_t i = 0; i < hashedServiceKeys.size(); ++i) {
-      CacheType& keymap = cache[i];
-      std::vector<std::string>& l = sle.GetLocalCache()[i];
-      for (std::vector<std::string>::const_iterator it = l.begin();
-           it != l.end();
-           ++it) {
-        std::list<ServiceListenerEntry>& sles = keymap[*it];
-        sles.remove(sle);
-        if (sles.empty()) {
-          keymap.erase(*it);
+  for (auto& pos : sle.GetCachePositions()) {
+    CacheType::iterator cacheIter;
+    ListenerBucket* bucket = pos.cacheIx == UNRESOLVED_IX
+                               ? &unresolvedListeners
+                               : &complicatedListeners;
+    if (pos.cacheIx < COMPLICATED_IX) {
+      cacheIter = cache[pos.cacheIx].find(pos.key);
+      assert(cacheIter != cache[pos.cacheIx].end());
+      bucket = &cacheIter->second;
+    }
+
+    // Move the last entry of the bucket into the freed slot and
+    // update its recorded position.
+    const std::size_t last = bucket->size() - 1;
+    if (pos.index != last) {
+      ServiceListenerEntry& moved = (*bucket)[last];
+      for (auto& movedPos : moved.GetCachePositions()) {
+        if (movedPos.cacheIx == pos.cacheIx && movedPos.key == pos.key &&
+            movedPos.index == last) {
+          movedPos.index = pos.index;
+          break;
         }
       }
+      (*bucket)[pos.index] = moved;
+    }
+    bucket->pop_back();
+
+    if (bucket->empty() && pos.cacheIx < COMPLICATED_IX) {
+      cache[pos.cacheIx].erase(cacheIter);
     }
-  } else {
-    complicatedListeners.remove(sle);
   }
+  sle.GetCachePositions().clear();
 }
 
 void ServiceListeners::CheckSimple_unlocked(const ServiceListenerEntry& sle)
 {
-  if (sle.GetLDAPExpr().IsNull()) {
-    complicatedListeners.push_back(sle);
-  } else {
-    LDAPExpr::LocalCache local_cache;
-    if (sle.GetLDAPExpr().IsSimple(hashedServiceKeys, local_cache, false)) {
-      sle.GetLocalCache() = local_cache;
-      for (std::size_t i = 0; i < hashedServiceKeys.size(); ++i) {
-        for (std::vector<std::string>::const_iterator it =
-               local_cache[i].begin();
-             it != local_cache[i].end();
-             ++it) {
-          std::list<ServiceListenerEntry>& sles = cache[i][*it];
-          sles.push_back(sle);
-        }
-      }
-    } else {
-      complicatedListeners.push_back(sle);
+  LDAPExpr::LocalCache local_cache;
+  if (sle.GetLDAPExpr().IsNull() ||
+      !sle.GetLDAPExpr().IsSimple(hashedServiceKeys, local_cache, false)) {
+    AddToBucket_unlocked(sle, COMPLICATED_IX, 0);
+    return;
+  }
+
+  // Object classes are looked up, not interned, so that filters do not
+  // grow the interface id table.
+  std::vector<std::size_t> interfaceIds;
+  for (auto& objClass : local_cache[OBJECTCLASS_IX]) {
+    std::size_t interfaceId = 0;
+    if (!InterfaceIdTable::Global().FindId(objClass, interfaceId)) {
+      AddToBucket_unlocked(sle, COMPLICATED_IX, 0);
+      AddToBucket_unlocked(sle, UNRESOLVED_IX, 0);
+      return;
+    }
+    interfaceIds.push_back(interfaceId);
+  }
+
+  for (auto interfaceId : interfaceIds) {
+    AddToBucket_unlocked(
+      sle, OBJECTCLASS_IX, static_cast<long>(interfaceId));
+  }
+
+  for (auto& serviceId : local_cache[SERVICE_ID_IX]) {
+    // Service ids are compared by their canonical string representation.
+    // Any other value never matches a service id and needs no bucket.
+    char* end = nullptr;
+    long id = std::strtol(serviceId.c_str(), &end, 10);
+    if (cppmicroservices::util::ToString(id) == serviceId) {
+      AddToBucket_unlocked(sle, SERVICE_ID_IX, id);
     }
   }
 }
 
+void ServiceListeners::ResolveListeners_unlocked()
+{
+  if (unresolvedListeners.empty()) {
+    return;
+  }
+  auto interfaceCount = InterfaceIdTable::Global().Size();
+  if (interfaceCount == resolvedInterfaceCount) {
+    return;
+  }
+  resolvedInterfaceCount = interfaceCount;
+
+  ListenerBucket unresolved;
+  unresolved.swap(unresolvedListeners);
+  for (auto& sle : unresolved) {
+    // The position in the swapped out bucket is stale
+    auto& positions = sle.GetCachePositions();
+    positions.erase(
+      std::remove_if(positions.begin(),
+                     positions.end(),
+                     [](const ServiceListenerEntry::CachePosition& pos) {
+                       return pos.cacheIx == UNRESOLVED_IX;
+                     }),
+      positions.end());
+    RemoveFromCache_unlocked(sle);
+    CheckSimple_unlocked(sle);
+  }
+}
+
+void ServiceListeners::AddToBucket_unlocked(const ServiceListenerEntry& sle,
+                                            int cache_ix,
+                                            long key)
+{
+  ListenerBucket& bucket =
+    cache_ix == COMPLICATED_IX
+      ? complicatedListeners
+      : cache_ix == UNRESOLVED_IX ? unresolvedListeners : cache[cache_ix][key];
+  sle.GetCachePositions().push_back({ cache_ix, key, bucket.size() });
+  bucket.push_back(sle);
+}
+
 void ServiceListeners::AddToSet_unlocked(
   ServiceListenerEntries& set,
-  const ServiceListenerEntries& receivers,
+  const ServiceListenerEntries* receivers,
   int cache_ix,
-  const std::string& val)
+  long key)
 {
-  std::list<ServiceListenerEntry>& l = cache[cache_ix][val];
-  if (!l.empty()) {
-
-    for (std::list<ServiceListenerEntry>::const_iterator entry = l.begin();
-         entry != l.end();
-         ++entry) {
-      if (receivers.count(*entry)) {
-        set.insert(*entry);
+  auto iter = cache[cache_ix].find(key);
+  if (iter != cache[cache_ix].end()) {
+    for (auto& entry : iter->second) {
+      if (!receivers || receivers->count(entry)) {
+        set.insert(entry);
       }
     }
   }
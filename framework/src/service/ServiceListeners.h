@@ -26,15 +26,18 @@
 #include "cppmicroservices/GlobalConfig.h"
 #include "cppmicroservices/detail/Threads.h"
 
+#include "EventDispatcher.h"
 #include "ServiceListenerEntry.h"
 
 #include <list>
+#include <memory>
 #include <mutex>
 #include <set>
 #include <string>
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 namespace cppmicroservices {
 
@@ -58,7 +61,8 @@ public:
     BundleListenerMap value;
   } bundleListenerMap;
 
-  using CacheType = std::unordered_map<std::string, std::list<ServiceListenerEntry>>;
+  using ListenerBucket = std::vector<ServiceListenerEntry>;
+  using CacheType = std::unordered_map<long, ListenerBucket>;
   using ServiceListenerEntries = std::unordered_set<ServiceListenerEntry>;
 
   using FrameworkListenerEntry = std::tuple<FrameworkListener, void*>;
@@ -76,17 +80,47 @@ private:
   std::vector<std::string> hashedServiceKeys;
   static const int OBJECTCLASS_IX = 0;
   static const int SERVICE_ID_IX = 1;
+  static const int COMPLICATED_IX = 2;
+  static const int UNRESOLVED_IX = 3;
 
   /* Service listeners with complicated or empty filters */
-  std::list<ServiceListenerEntry> complicatedListeners;
+  ListenerBucket complicatedListeners;
 
-  /* Service listeners with "simple" filters are cached. */
+  /**
+   * Service listeners with simple filters naming an object class which
+   * has no interned id yet. They are also in complicatedListeners and
+   * are checked again when new ids were interned.
+   */
+  ListenerBucket unresolvedListeners;
+
+  //! Number of interned interface ids when unresolvedListeners was checked
+  std::size_t resolvedInterfaceCount;
+
+  /**
+   * Service listeners with "simple" filters are cached. Object classes
+   * are keyed by their interned id (see InterfaceIdTable), service ids
+   * by value.
+   */
   CacheType cache[2];
 
   ServiceListenerEntries serviceSet;
 
+  /**
+   * Immutable copy of serviceSet for service event listener hooks. It
+   * is reset whenever serviceSet changes and rebuilt on demand, so that
+   * service events do not copy all listeners while the set is stable.
+   */
+  std::shared_ptr<const ServiceListenerEntries> serviceSetSnapshot;
+
   CoreBundleContext* coreCtx;
 
+  /**
+   * Delivers bundle and service events if asynchronous event delivery
+   * is enabled, see Constants::FRAMEWORK_EVENT_DELIVERY. Events are
+   * queued per bundle context owning the listeners.
+   */
+  std::unique_ptr<EventDispatcher> eventDispatcher;
+
 public:
   ServiceListeners(CoreBundleContext* coreCtx);
 
@@ -227,7 +261,47 @@ public:
   std::vector<ServiceListenerHook::ListenerInfo> GetListenerInfoCollection()
     const;
 
+  /**
+   * The number of events queued for asynchronous delivery.
+   */
+  std::size_t GetEventQueueDepth() const;
+
+  /**
+   * The largest number of events queued for the listeners of a single
+   * bundle context.
+   */
+  std::size_t GetEventQueueMaxDepth() const;
+
+  /**
+   * Deliver the events which are queued for asynchronous delivery. If
+   * called while delivering an event, this waits until the events of
+   * other bundle contexts were delivered.
+   */
+  void DrainEvents();
+
+  /**
+   * Deliver the queued events and stop the asynchronous delivery
+   * threads. Events are delivered synchronously afterwards.
+   */
+  void StopEventDelivery();
+
 private:
+  void DeliverBundleEvent(
+    const std::shared_ptr<BundleContextPrivate>& context,
+    const std::unordered_map<ListenerTokenId, BundleListenerEntry>& listeners,
+    const BundleEvent& evt);
+
+  /**
+   * Whether the bundle listener is still registered. Bundle events are
+   * delivered to a copy of the listeners, which may be stale.
+   */
+  bool IsBundleListenerRegistered(
+    const std::shared_ptr<BundleContextPrivate>& context,
+    ListenerTokenId tokenId) const;
+
+  void DeliverServiceEvent(const ServiceListenerEntry& listener,
+                           const ServiceEvent& evt);
+
   /**
    * Factory method that returns an unique ListenerToken object.
    * Called by methods which add listeners.
@@ -246,10 +320,34 @@ private:
    */
   void CheckSimple_unlocked(const ServiceListenerEntry& sle);
 
+  /**
+   * Check the listeners in unresolvedListeners again if object classes
+   * were interned since the last check.
+   */
+  void ResolveListeners_unlocked();
+
+  /**
+   * Append a service listener to the bucket identified by
+   * <code>cache_ix</code> and <code>key</code> and record its position.
+   */
+  void AddToBucket_unlocked(const ServiceListenerEntry& sle,
+                            int cache_ix,
+                            long key);
+
+  /**
+   * Get an immutable snapshot of all service listeners.
+   */
+  std::shared_ptr<const ServiceListenerEntries> GetServiceSetSnapshot();
+
+  /**
+   * Add the cached listeners for <code>key</code> to <code>set</code>.
+   * If <code>receivers</code> is not <code>nullptr</code>, only
+   * listeners contained in <code>receivers</code> are added.
+   */
   void AddToSet_unlocked(ServiceListenerEntries& set,
-                         const ServiceListenerEntries& receivers,
+                         const ServiceListenerEntries* receivers,
                          int cache_ix,
-                         const std::string& val);
+                         long key);
 };
 }
 
@@ -137,45 +137,20 @@ bool ServiceReferenceBase::operator<(
     return false;
   }
 
-  Any anyR1;
-  Any anyId1;
-  {
-    auto l = d.load()->registration->properties.Lock();
-    US_UNUSED(l);
-    anyR1 = d.load()->registration->properties.Value_unlocked(
-      Constants::SERVICE_RANKING);
-    assert(anyR1.Empty() || anyR1.Type() == typeid(int));
-    anyId1 =
-      d.load()->registration->properties.Value_unlocked(Constants::SERVICE_ID);
-    assert(anyId1.Type() == typeid(long int));
-  }
-
-  Any anyR2;
-  Any anyId2;
-  {
-    auto l = reference.d.load()->registration->properties.Lock();
-    US_UNUSED(l);
-    anyR2 = reference.d.load()->registration->properties.Value_unlocked(
-      Constants::SERVICE_RANKING);
-    assert(anyR2.Empty() || anyR2.Type() == typeid(int));
-    anyId2 = reference.d.load()->registration->properties.Value_unlocked(
-      Constants::SERVICE_ID);
-    assert(anyId2.Type() == typeid(long int));
-  }
+  const ServiceRegistrationBasePrivate* reg1 = d.load()->registration;
+  const ServiceRegistrationBasePrivate* reg2 =
+    reference.d.load()->registration;
 
-  const int r1 = anyR1.Empty() ? 0 : *any_cast<int>(&anyR1);
-  const int r2 = anyR2.Empty() ? 0 : *any_cast<int>(&anyR2);
+  const int r1 = reg1->ranking;
+  const int r2 = reg2->ranking;
 
   if (r1 != r2) {
     // use ranking if ranking differs
     return r1 < r2;
   } else {
-    const long int id1 = *any_cast<long int>(&anyId1);
-    const long int id2 = *any_cast<long int>(&anyId2);
-
     // otherwise compare using IDs,
     // is less than if it has a higher ID.
-    return id2 < id1;
+    return reg2->serviceId < reg1->serviceId;
   }
 }
 
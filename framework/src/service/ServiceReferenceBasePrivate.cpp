@@ -79,24 +79,32 @@ InterfaceMapConstPtr ServiceReferenceBasePrivate::GetServiceFromFactory(
             "ServiceFactory returned an invalid interface map"))));
       return smap;
     }
-    std::vector<std::string> classes =
-      (registration->properties.Lock(),
-       any_cast<std::vector<std::string>>(
-         registration->properties.Value_unlocked(Constants::OBJECTCLASS)));
-    for (auto clazz : classes) {
-      if (smap->find(clazz) == smap->end() &&
-          clazz != "org.cppmicroservices.factory") {
-        std::string message(
-          "ServiceFactory produced an object that did not implement: " + clazz);
-        registration->bundle->coreCtx->listeners.SendFrameworkEvent(
-          FrameworkEvent(
-            FrameworkEvent::Type::FRAMEWORK_WARNING,
-            MakeBundle(bundle->shared_from_this()),
-            message,
-            std::make_exception_ptr(std::logic_error(message.c_str()))));
-        return nullptr;
+    std::string missingClass;
+    {
+      auto l = registration->properties.Lock();
+      US_UNUSED(l);
+      const auto& classes = ref_any_cast<std::vector<std::string>>(
+        registration->properties.Value_unlocked(Constants::OBJECTCLASS));
+      for (const auto& clazz : classes) {
+        if (smap->find(clazz) == smap->end() &&
+            clazz != "org.cppmicroservices.factory") {
+          missingClass = clazz;
+          break;
+        }
       }
     }
+    if (!missingClass.empty()) {
+      std::string message(
+        "ServiceFactory produced an object that did not implement: " +
+        missingClass);
+      registration->bundle->coreCtx->listeners.SendFrameworkEvent(
+        FrameworkEvent(
+          FrameworkEvent::Type::FRAMEWORK_WARNING,
+          MakeBundle(bundle->shared_from_this()),
+          message,
+          std::make_exception_ptr(std::logic_error(message.c_str()))));
+      return nullptr;
+    }
     s = smap;
   } catch (...) {
     s.reset();
@@ -114,13 +122,18 @@ InterfaceMapConstPtr ServiceReferenceBasePrivate::GetPrototypeService(
 {
   InterfaceMapConstPtr s;
   {
+    if (auto owner = (registration->Lock(), registration->bundle)) {
+      owner->TriggerLazyActivation();
+    }
     if (registration->available) {
       auto factory = std::static_pointer_cast<ServiceFactory>(
         registration->GetService("org.cppmicroservices.factory"));
       s = GetServiceFromFactory(GetPrivate(bundle).get(), factory);
-      registration->Lock(),
-        registration->prototypeServiceInstances[GetPrivate(bundle).get()]
-          .push_back(s);
+      auto b = GetPrivate(bundle);
+      auto l = registration->Lock();
+      US_UNUSED(l);
+      registration->prototypeServiceInstances[b.get()].push_back(s);
+      b->AddUsedService(ServiceRegistrationBase(registration));
     }
   }
   return s;
@@ -153,6 +166,16 @@ InterfaceMapConstPtr ServiceReferenceBasePrivate::GetServiceInterfaceMap(
   InterfaceMapConstPtr s;
   if (!registration->available)
     return s;
+
+  // The first request for a service of a bundle with a lazy activation
+  // policy activates the bundle. A failed activation unregisters the
+  // service.
+  if (auto owner = (registration->Lock(), registration->bundle)) {
+    owner->TriggerLazyActivation();
+  }
+  if (!registration->available)
+    return s;
+
   std::shared_ptr<ServiceFactory> serviceFactory;
 
   std::unordered_set<ServiceRegistrationBasePrivate*>* marks = nullptr;
@@ -179,6 +202,9 @@ InterfaceMapConstPtr ServiceReferenceBasePrivate::GetServiceInterfaceMap(
 
     auto res = registration->dependents.insert(std::make_pair(bundle, 0));
     auto& depCounter = res.first->second;
+    if (res.second) {
+      bundle->AddUsedService(ServiceRegistrationBase(registration));
+    }
 
     // No service factory, just return the registered service directly.
     if (!serviceFactory) {
@@ -224,7 +250,9 @@ InterfaceMapConstPtr ServiceReferenceBasePrivate::GetServiceInterfaceMap(
   auto l = registration->Lock();
   US_UNUSED(l);
 
-  registration->dependents.insert(std::make_pair(bundle, 0));
+  if (registration->dependents.insert(std::make_pair(bundle, 0)).second) {
+    bundle->AddUsedService(ServiceRegistrationBase(registration));
+  }
 
   if (s && !s->empty()) {
     // Insert a cached service object instance only if one isn't already cached. If another thread
@@ -296,6 +324,9 @@ bool ServiceReferenceBasePrivate::UngetPrototypeService(
         iter->second.erase(serviceIter);
       if (iter->second.empty()) {
         registration->prototypeServiceInstances.erase(iter);
+        if (registration->dependents.count(bundle.get()) == 0) {
+          bundle->RemoveUsedService(ServiceRegistrationBase(registration));
+        }
       }
       return true;
     }
@@ -348,6 +379,9 @@ bool ServiceReferenceBasePrivate::UngetService(
       }
       registration->bundleServiceInstance.erase(bundle.get());
       registration->dependents.erase(bundle.get());
+      if (registration->prototypeServiceInstances.count(bundle.get()) == 0) {
+        bundle->RemoveUsedService(ServiceRegistrationBase(registration));
+      }
     }
   }
 
@@ -135,7 +135,6 @@ void ServiceRegistrationBase::SetProperties(const ServiceProperties& props)
 
     int old_rank = 0;
     int new_rank = 0;
-    std::vector<std::string> classes;
     {
       auto l = d->Lock();
       US_UNUSED(l);
@@ -146,26 +145,23 @@ void ServiceRegistrationBase::SetProperties(const ServiceProperties& props)
         auto l2 = d->properties.Lock();
         US_UNUSED(l2);
 
-        Any any = d->properties.Value_unlocked(Constants::SERVICE_RANKING);
-        if (any.Type() == typeid(int))
-          old_rank = any_cast<int>(any);
+        old_rank = d->ranking;
 
-        classes = ref_any_cast<std::vector<std::string>>(
+        const auto& classes = ref_any_cast<std::vector<std::string>>(
           d->properties.Value_unlocked(Constants::OBJECTCLASS));
 
-        auto sid = any_cast<long int>(
-          d->properties.Value_unlocked(Constants::SERVICE_ID));
-        d->properties = ServiceRegistry::CreateServiceProperties(
-          props, classes, false, false, sid);
+        // classes refers into the old properties, which must stay alive
+        // until the new ones have been created
+        Properties newProps = ServiceRegistry::CreateServiceProperties(
+          props, classes, false, false, d->serviceId);
+        d->properties = std::move(newProps);
 
-        any = d->properties.Value_unlocked(Constants::SERVICE_RANKING);
-        if (any.Type() == typeid(int))
-          new_rank = any_cast<int>(any);
+        d->UpdateRanking_unlocked();
+        new_rank = d->ranking;
       }
     }
     if (old_rank != new_rank) {
-      d->bundle->coreCtx->services.UpdateServiceRegistrationOrder(*this,
-                                                                  classes);
+      d->bundle->coreCtx->services.UpdateServiceRegistrationOrder(*this);
     }
   } else {
     throw std::logic_error("Service is unregistered");
@@ -277,6 +273,13 @@ void ServiceRegistrationBase::Unregister()
     auto l = d->Lock();
     US_UNUSED(l);
 
+    for (auto& dependent : d->dependents) {
+      dependent.first->RemoveUsedService(*this);
+    }
+    for (auto& i : d->prototypeServiceInstances) {
+      i.first->RemoveUsedService(*this);
+    }
+
     d->bundle = nullptr;
     d->dependents.clear();
     d->service.reset();
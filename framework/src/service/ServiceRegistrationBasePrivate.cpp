@@ -22,6 +22,10 @@
 
 #include "ServiceRegistrationBasePrivate.h"
 
+#include "cppmicroservices/Constants.h"
+
+#include "InterfaceIdTable.h"
+
 #include <utility>
 
 #ifdef _MSC_VER
@@ -31,6 +35,27 @@
 
 namespace cppmicroservices {
 
+namespace {
+
+std::vector<std::size_t> GetInterfaceIds(const InterfaceMapConstPtr& service)
+{
+  std::vector<std::size_t> ids;
+  if (service) {
+    ids.reserve(service->size());
+    for (auto& i : *service) {
+      ids.push_back(InterfaceIdTable::Global().GetId(i.first));
+    }
+  }
+  return ids;
+}
+
+int GetRanking(const Properties& props)
+{
+  const Any& any = props.Value_unlocked(Constants::SERVICE_RANKING);
+  return any.Type() == typeid(int) ? *any_cast<int>(&any) : 0;
+}
+}
+
 ServiceRegistrationBasePrivate::ServiceRegistrationBasePrivate(
   BundlePrivate* bundle,
   InterfaceMapConstPtr  service,
@@ -40,6 +65,9 @@ ServiceRegistrationBasePrivate::ServiceRegistrationBasePrivate(
   , bundle(bundle)
   , reference(this)
   , properties(std::move(props))
+  , interfaceIds(GetInterfaceIds(this->service))
+  , serviceId(any_cast<long>(properties.Value_unlocked(Constants::SERVICE_ID)))
+  , ranking(GetRanking(properties))
   , available(true)
   , unregistering(false)
 {
@@ -52,6 +80,11 @@ ServiceRegistrationBasePrivate::~ServiceRegistrationBasePrivate()
   properties.Lock(), properties.Clear_unlocked();
 }
 
+void ServiceRegistrationBasePrivate::UpdateRanking_unlocked()
+{
+  ranking = GetRanking(properties);
+}
+
 bool ServiceRegistrationBasePrivate::IsUsedByBundle(BundlePrivate* bundle) const
 {
   auto l = this->Lock();
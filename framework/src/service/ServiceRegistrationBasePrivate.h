@@ -30,6 +30,7 @@
 #include "Properties.h"
 
 #include <atomic>
+#include <vector>
 
 namespace cppmicroservices {
 
@@ -103,6 +104,23 @@ public:
    */
   Properties properties;
 
+  /**
+   * Interned ids of the interfaces in <code>service</code>, i.e. of the
+   * class names under which the service is registered.
+   */
+  const std::vector<std::size_t> interfaceIds;
+
+  /**
+   * The service id, which never changes after registration.
+   */
+  const long serviceId;
+
+  /**
+   * The service ranking, cached from the service properties so that
+   * service references can be ordered without locking the properties.
+   */
+  std::atomic<int> ranking;
+
   /**
    * Is service available. I.e., if <code>true</code> then holders
    * of a ServiceReference for the service are allowed to get it.
@@ -130,6 +148,12 @@ public:
    */
   bool IsUsedByBundle(BundlePrivate* bundle) const;
 
+  /**
+   * Update the cached ranking from the service properties. Must be
+   * called with the properties lock held after the properties changed.
+   */
+  void UpdateRanking_unlocked();
+
   InterfaceMapConstPtr GetInterfaces() const;
 
   std::shared_ptr<void> GetService(const std::string& interfaceId) const;
@@ -27,8 +27,11 @@
 
 #include "BundlePrivate.h"
 #include "CoreBundleContext.h"
+#include "InterfaceIdTable.h"
+#include "LDAPExprCache.h"
 #include "ServiceRegistrationBasePrivate.h"
 
+#include <algorithm>
 #include <cassert>
 #include <iterator>
 #include <stdexcept>
@@ -40,7 +43,7 @@ void ServiceRegistry::Clear()
   auto l = this->Lock();
   US_UNUSED(l);
   services.clear();
-  classServices.clear();
+  classServices.Store(std::make_shared<const MapClassServices>());
   serviceRegistrations.clear();
 }
 
@@ -77,7 +80,9 @@ Properties ServiceRegistry::CreateServiceProperties(
 
 ServiceRegistry::ServiceRegistry(CoreBundleContext* coreCtx)
   : core(coreCtx)
-{}
+{
+  classServices.Store(std::make_shared<const MapClassServices>());
+}
 
 ServiceRegistrationBase ServiceRegistry::RegisterService(
   BundlePrivate* bundle,
@@ -117,11 +122,18 @@ ServiceRegistrationBase ServiceRegistry::RegisterService(
     US_UNUSED(l);
     services.insert(std::make_pair(res, classes));
     serviceRegistrations.push_back(res);
-    for (auto& clazz : classes) {
-      std::vector<ServiceRegistrationBase>& s = classServices[clazz];
+    bundle->AddRegisteredService(res);
+    for (auto interfaceId : res.d->interfaceIds) {
+      auto current = GetClassServices(interfaceId);
+      ServiceRegistrations s;
+      if (current) {
+        s.reserve(current->size() + 1);
+        s = *current;
+      }
       auto ip =
         std::lower_bound(s.begin(), s.end(), res);
       s.insert(ip, res);
+      SetClassServices_unlocked(interfaceId, std::move(s));
     }
   }
 
@@ -135,43 +147,98 @@ ServiceRegistrationBase ServiceRegistry::RegisterService(
 }
 
 void ServiceRegistry::UpdateServiceRegistrationOrder(
-  const ServiceRegistrationBase& sr,
-  const std::vector<std::string>& classes)
+  const ServiceRegistrationBase& sr)
 {
   auto l = this->Lock();
   US_UNUSED(l);
-  for (auto& clazz : classes) {
-    std::vector<ServiceRegistrationBase>& s = classServices[clazz];
+  for (auto interfaceId : sr.d->interfaceIds) {
+    auto current = GetClassServices(interfaceId);
+    if (!current) {
+      continue;
+    }
+    ServiceRegistrations s(*current);
     s.erase(std::remove(s.begin(), s.end(), sr), s.end());
     s.insert(std::lower_bound(s.begin(), s.end(), sr), sr);
+    SetClassServices_unlocked(interfaceId, std::move(s));
+  }
+}
+
+ServiceRegistry::ServiceRegistrationsConstPtr ServiceRegistry::GetClassServices(
+  std::size_t interfaceId) const
+{
+  auto classServicesSnapshot = classServices.Load();
+  auto i = classServicesSnapshot->find(interfaceId);
+  if (i == classServicesSnapshot->end()) {
+    return nullptr;
+  }
+  return i->second->Load();
+}
+
+ServiceRegistry::ServiceRegistrationsConstPtr ServiceRegistry::GetClassServices(
+  const std::string& clazz) const
+{
+  std::size_t interfaceId = 0;
+  if (!InterfaceIdTable::Global().FindId(clazz, interfaceId)) {
+    // never registered or listened to
+    return nullptr;
   }
+  return GetClassServices(interfaceId);
+}
+
+void ServiceRegistry::SetClassServices_unlocked(std::size_t interfaceId,
+                                                ServiceRegistrations&& regs)
+{
+  auto current = classServices.Load();
+  auto i = current->find(interfaceId);
+  if (!regs.empty() && i != current->end()) {
+    // The class name is already known, only publish the new list
+    i->second->Store(
+      std::make_shared<const ServiceRegistrations>(std::move(regs)));
+    return;
+  }
+
+  auto next = std::make_shared<MapClassServices>(*current);
+  if (regs.empty()) {
+    if (i == current->end()) {
+      return;
+    }
+    // Readers still holding the old map must not see the removed services
+    i->second->Store(nullptr);
+    next->erase(interfaceId);
+  } else {
+    auto slot = std::make_shared<ServiceRegistrationsSlot>();
+    slot->Store(std::make_shared<const ServiceRegistrations>(std::move(regs)));
+    next->insert(std::make_pair(interfaceId, slot));
+  }
+  classServices.Store(std::move(next));
 }
 
 void ServiceRegistry::Get(
   const std::string& clazz,
   std::vector<ServiceRegistrationBase>& serviceRegs) const
 {
-  this->Lock(), Get_unlocked(clazz, serviceRegs);
+  auto s = GetClassServices(clazz);
+  if (s) {
+    serviceRegs = *s;
+  }
 }
 
-void ServiceRegistry::Get_unlocked(
-  const std::string& clazz,
+void ServiceRegistry::Get(
+  std::size_t interfaceId,
   std::vector<ServiceRegistrationBase>& serviceRegs) const
 {
-  auto i = classServices.find(clazz);
-  if (i != classServices.end()) {
-    serviceRegs = i->second;
+  auto s = GetClassServices(interfaceId);
+  if (s) {
+    serviceRegs = *s;
   }
 }
 
 ServiceReferenceBase ServiceRegistry::Get(BundlePrivate* bundle,
                                           const std::string& clazz) const
 {
-  auto l = this->Lock();
-  US_UNUSED(l);
   try {
     std::vector<ServiceReferenceBase> srs;
-    Get_unlocked(clazz, "", bundle, srs);
+    Get(clazz, "", bundle, srs);
     DIAG_LOG(*core->sink) << "get service ref " << clazz << " for bundle "
                           << bundle->symbolicName << " = " << srs.size()
                           << " refs";
@@ -190,64 +257,57 @@ void ServiceRegistry::Get(const std::string& clazz,
                           BundlePrivate* bundle,
                           std::vector<ServiceReferenceBase>& res) const
 {
-  this->Lock(), Get_unlocked(clazz, filter, bundle, res);
-}
-
-void ServiceRegistry::Get_unlocked(const std::string& clazz,
-                                   const std::string& filter,
-                                   BundlePrivate* bundle,
-                                   std::vector<ServiceReferenceBase>& res) const
-{
-  std::vector<ServiceRegistrationBase>::const_iterator s;
-  std::vector<ServiceRegistrationBase>::const_iterator send;
-  std::vector<ServiceRegistrationBase> v;
+  // Snapshots of the registrations to search. They keep the searched
+  // lists alive while iterating without holding the registry lock.
+  std::vector<ServiceRegistrationsConstPtr> snapshots;
   LDAPExpr ldap;
   if (clazz.empty()) {
     if (!filter.empty()) {
-      ldap = LDAPExpr(filter);
-      LDAPExpr::ObjectClassSet matched;
-      if (ldap.GetMatchedObjectClasses(matched)) {
-        v.clear();
-        for (auto& className : matched) {
-          auto i = classServices.find(className);
-          if (i != classServices.end()) {
-            std::copy(
-              i->second.begin(), i->second.end(), std::back_inserter(v));
-          }
-        }
-        if (!v.empty()) {
-          s = v.begin();
-          send = v.end();
-        } else {
-          return;
+      ldap = LDAPExprCache::Global().Get(filter);
+    }
+    LDAPExpr::ObjectClassSet matched;
+    if (!filter.empty() && ldap.GetMatchedObjectClasses(matched)) {
+      for (auto& className : matched) {
+        auto regs = GetClassServices(className);
+        if (regs) {
+          snapshots.push_back(std::move(regs));
         }
-      } else {
-        s = serviceRegistrations.begin();
-        send = serviceRegistrations.end();
+      }
+      if (snapshots.empty()) {
+        return;
       }
     } else {
-      s = serviceRegistrations.begin();
-      send = serviceRegistrations.end();
+      auto l = this->Lock();
+      US_UNUSED(l);
+      snapshots.push_back(
+        std::make_shared<const ServiceRegistrations>(serviceRegistrations));
     }
   } else {
-    auto it = classServices.find(clazz);
-    if (it != classServices.end()) {
-      s = it->second.begin();
-      send = it->second.end();
-    } else {
+    auto regs = GetClassServices(clazz);
+    if (!regs) {
       return;
     }
+    snapshots.push_back(std::move(regs));
     if (!filter.empty()) {
-      ldap = LDAPExpr(filter);
+      ldap = LDAPExprCache::Global().Get(filter);
     }
   }
 
-  for (; s != send; ++s) {
-    ServiceReferenceBase sri = s->GetReference(clazz);
+  for (auto& snapshot : snapshots) {
+    for (auto& reg : *snapshot) {
+      if (!reg.d->available) {
+        // unregistered after the snapshot was taken
+        continue;
+      }
 
-    if (filter.empty() ||
-        ldap.Evaluate(PropertiesHandle(s->d->properties, true), false)) {
-      res.push_back(sri);
+      if (filter.empty() ||
+          ldap.Evaluate(PropertiesHandle(reg.d->properties, true), false)) {
+        try {
+          res.push_back(reg.GetReference(clazz));
+        } catch (const std::logic_error&) {
+          // unregistered concurrently
+        }
+      }
     }
   }
 
@@ -272,26 +332,23 @@ void ServiceRegistry::RemoveServiceRegistration(
 void ServiceRegistry::RemoveServiceRegistration_unlocked(
   const ServiceRegistrationBase& sr)
 {
-  std::vector<std::string> classes;
-  {
-    auto l2 = sr.d->properties.Lock();
-    US_UNUSED(l2);
-    assert(sr.d->properties.Value_unlocked(Constants::OBJECTCLASS).Type() ==
-           typeid(std::vector<std::string>));
-    classes = ref_any_cast<std::vector<std::string>>(
-      sr.d->properties.Value_unlocked(Constants::OBJECTCLASS));
-  }
   services.erase(sr);
+  if (sr.d->bundle) {
+    sr.d->bundle->RemoveRegisteredService(sr);
+  }
   serviceRegistrations.erase(
     std::remove(serviceRegistrations.begin(), serviceRegistrations.end(), sr),
     serviceRegistrations.end());
-  for (auto& clazz : classes) {
-    std::vector<ServiceRegistrationBase>& s = classServices[clazz];
-    if (s.size() > 1) {
-      s.erase(std::remove(s.begin(), s.end(), sr), s.end());
-    } else {
-      classServices.erase(clazz);
+  for (auto interfaceId : sr.d->interfaceIds) {
+    auto current = GetClassServices(interfaceId);
+    if (!current) {
+      continue;
     }
+    ServiceRegistrations s;
+    s.reserve(current->size());
+    std::remove_copy(
+      current->begin(), current->end(), std::back_inserter(s), sr);
+    SetClassServices_unlocked(interfaceId, std::move(s));
   }
 }
 
@@ -299,26 +356,17 @@ void ServiceRegistry::GetRegisteredByBundle(
   BundlePrivate* p,
   std::vector<ServiceRegistrationBase>& res) const
 {
-  auto l = this->Lock();
-  US_UNUSED(l);
-
-  for (auto& sr : serviceRegistrations) {
-    if (sr.d->bundle == p) {
-      res.push_back(sr);
-    }
-  }
+  auto regs = p->GetRegisteredServices();
+  res.insert(res.end(), regs.begin(), regs.end());
 }
 
 void ServiceRegistry::GetUsedByBundle(
   BundlePrivate* bundle,
   std::vector<ServiceRegistrationBase>& res) const
 {
-  auto l = this->Lock();
-  US_UNUSED(l);
-
-  for (const auto & serviceRegistration : serviceRegistrations) {
-    if (serviceRegistration.d->IsUsedByBundle(bundle)) {
-      res.push_back(serviceRegistration);
+  for (auto& reg : bundle->GetUsedServices()) {
+    if (reg.d->IsUsedByBundle(bundle)) {
+      res.push_back(reg);
     }
   }
 }
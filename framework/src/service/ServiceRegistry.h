@@ -59,7 +59,12 @@ public:
     long sid = -1);
 
   using MapServiceClasses = std::unordered_map<ServiceRegistrationBase, std::vector<std::string>>;
-  using MapClassServices = std::unordered_map<std::string, std::vector<ServiceRegistrationBase>>;
+
+  using ServiceRegistrations = std::vector<ServiceRegistrationBase>;
+  using ServiceRegistrationsConstPtr = std::shared_ptr<const ServiceRegistrations>;
+  using ServiceRegistrationsSlot = detail::Atomic<ServiceRegistrationsConstPtr>;
+  using MapClassServices = std::unordered_map<std::size_t, std::shared_ptr<ServiceRegistrationsSlot>>;
+  using MapClassServicesConstPtr = std::shared_ptr<const MapClassServices>;
 
   /**
    * All registered services in the current framework.
@@ -71,11 +76,18 @@ public:
   std::vector<ServiceRegistrationBase> serviceRegistrations;
 
   /**
-   * Mapping of classname to registered service.
+   * Mapping of interned class name ids (see InterfaceIdTable) to
+   * registered service.
    * The List of registered services are ordered with the highest
    * ranked service first.
+   *
+   * Lookups do not take the registry lock. Both the map and the
+   * per-class lists are immutable snapshots which are replaced
+   * atomically by writers holding the registry lock. A new map is
+   * only published when a class name is added or removed; otherwise
+   * only the slot of the affected class is updated.
    */
-  MapClassServices classServices;
+  detail::Atomic<MapClassServicesConstPtr> classServices;
 
   CoreBundleContext* core;
 
@@ -108,21 +120,34 @@ public:
    * according to ranking.
    *
    * @param serviceRegistration The ServiceRegistrationPrivate object.
-   * @param rank New rank of object.
    */
-  void UpdateServiceRegistrationOrder(const ServiceRegistrationBase& sr,
-                                      const std::vector<std::string>& classes);
+  void UpdateServiceRegistrationOrder(const ServiceRegistrationBase& sr);
 
   /**
    * Get all services implementing a certain class.
    * Only used internally by the framework.
    *
+   * This method does not lock the registry.
+   *
    * @param clazz The class name of the requested service.
    * @return A sorted list of {@link ServiceRegistrationPrivate} objects.
    */
   void Get(const std::string& clazz,
            std::vector<ServiceRegistrationBase>& serviceRegs) const;
 
+  /**
+   * Get all services implementing a certain class, identified by
+   * its interned id, e.g. from us_service_interface_id<T>().
+   * Only used internally by the framework.
+   *
+   * This method does not lock the registry.
+   *
+   * @param interfaceId The id of the class name of the requested service.
+   * @return A sorted list of {@link ServiceRegistrationPrivate} objects.
+   */
+  void Get(std::size_t interfaceId,
+           std::vector<ServiceRegistrationBase>& serviceRegs) const;
+
   /**
    * Get a service implementing a certain class.
    *
@@ -137,6 +162,10 @@ public:
    * Get all services implementing a certain class and then
    * filter these with a property filter.
    *
+   * Unless <code>clazz</code> is empty and the filter does not
+   * determine a set of class names, this method does not lock the
+   * registry.
+   *
    * @param clazz The class name of requested service.
    * @param filter The property filter.
    * @param bundle The bundle requesting reference.
@@ -179,13 +208,23 @@ private:
 
   void RemoveServiceRegistration_unlocked(const ServiceRegistrationBase& sr);
 
-  void Get_unlocked(const std::string& clazz,
-                    std::vector<ServiceRegistrationBase>& serviceRegs) const;
+  /**
+   * Get the current snapshot of services registered under the class
+   * with id <code>interfaceId</code>, or <code>nullptr</code> if there
+   * are none.
+   */
+  ServiceRegistrationsConstPtr GetClassServices(std::size_t interfaceId) const;
+
+  //! Same as above, for a class name.
+  ServiceRegistrationsConstPtr GetClassServices(const std::string& clazz) const;
 
-  void Get_unlocked(const std::string& clazz,
-                    const std::string& filter,
-                    BundlePrivate* bundle,
-                    std::vector<ServiceReferenceBase>& serviceRefs) const;
+  /**
+   * Publish a new list of services for the class with id
+   * <code>interfaceId</code>. An empty list removes the class. The
+   * caller must hold the registry lock.
+   */
+  void SetClassServices_unlocked(std::size_t interfaceId,
+                                 ServiceRegistrations&& regs);
 };
 }
 
@@ -68,8 +68,10 @@ std::ostream& any_value_to_json(std::ostream& os, bool val)
 // header in order to avoid this error:
 // "default initialization of an object of const type 'const cppmicroservices::Any' without
 // a user-provided default constructor"
-Any::Any() = default;
-    
+Any::Any()
+  : _content(nullptr)
+{}
+
 std::string Any::ToString() const
 {
   if (Empty()) {
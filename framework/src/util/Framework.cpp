@@ -71,4 +71,11 @@ FrameworkEvent Framework::WaitForStop(const std::chrono::milliseconds& timeout)
 {
   return pimpl(d)->WaitForStop(timeout);
 }
+
+std::vector<BundleStartTiming> Framework::StartBundles(
+  const std::vector<Bundle>& bundles,
+  uint32_t options)
+{
+  return pimpl(d)->StartBundles(bundles, options);
+}
 }
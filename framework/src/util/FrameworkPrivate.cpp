@@ -23,16 +23,159 @@ limitations under the License.
 #include "FrameworkPrivate.h"
 
 #include "cppmicroservices/BundleEvent.h"
+#include "cppmicroservices/Constants.h"
 #include "cppmicroservices/Framework.h"
 #include "cppmicroservices/FrameworkEvent.h"
+#include "cppmicroservices/util/String.h"
 
 #include "BundleContextPrivate.h"
+#include "BundleResourceContainer.h"
 #include "BundleStorage.h"
+#include "Parallel.h"
 
+#include <algorithm>
 #include <chrono>
+#include <set>
+#include <unordered_map>
 
 namespace cppmicroservices {
 
+namespace {
+
+std::string GetFileName(const std::string& path)
+{
+  return path.substr(path.find_last_of("/\\") + 1);
+}
+
+/**
+ * Number the strongly connected components of the graph with the edges
+ * i -> deps[i], using Tarjan's algorithm without recursion.
+ */
+std::vector<std::size_t> GetComponents(
+  const std::vector<std::vector<std::size_t>>& deps)
+{
+  const std::size_t n = deps.size();
+  const std::size_t unvisited = static_cast<std::size_t>(-1);
+  std::vector<std::size_t> component(n, unvisited);
+  std::vector<std::size_t> index(n, unvisited);
+  std::vector<std::size_t> lowLink(n, 0);
+  std::vector<bool> onStack(n, false);
+  std::vector<std::size_t> stack;
+  // The visited bundles and the position of their next dependency
+  std::vector<std::pair<std::size_t, std::size_t>> path;
+  std::size_t nextIndex = 0;
+  std::size_t numComponents = 0;
+
+  for (std::size_t root = 0; root < n; ++root) {
+    if (index[root] != unvisited) {
+      continue;
+    }
+    path.emplace_back(root, 0);
+    while (!path.empty()) {
+      const std::size_t v = path.back().first;
+      if (index[v] == unvisited) {
+        index[v] = lowLink[v] = nextIndex++;
+        stack.push_back(v);
+        onStack[v] = true;
+      }
+      if (path.back().second < deps[v].size()) {
+        const std::size_t w = deps[v][path.back().second++];
+        if (index[w] == unvisited) {
+          path.emplace_back(w, 0);
+        } else if (onStack[w]) {
+          lowLink[v] = std::min(lowLink[v], index[w]);
+        }
+        continue;
+      }
+
+      if (lowLink[v] == index[v]) {
+        std::size_t w = 0;
+        do {
+          w = stack.back();
+          stack.pop_back();
+          onStack[w] = false;
+          component[w] = numComponents;
+        } while (w != v);
+        ++numComponents;
+      }
+      path.pop_back();
+      if (!path.empty()) {
+        const std::size_t u = path.back().first;
+        lowLink[u] = std::min(lowLink[u], lowLink[v]);
+      }
+    }
+  }
+  return component;
+}
+
+/**
+ * For each bundle, the indices of the bundles which must be started
+ * before it. Within a cycle, dependencies on bundles which come later
+ * in the batch are dropped, so the result is acyclic. Dependencies
+ * which are not part of a cycle are kept.
+ */
+std::vector<std::vector<std::size_t>> GetStartDependencies(
+  CoreBundleContext* coreCtx,
+  const std::vector<std::shared_ptr<BundlePrivate>>& bundles)
+{
+  const std::size_t n = bundles.size();
+  std::unordered_multimap<std::string, std::size_t> byFileName;
+  std::unordered_multimap<std::string, std::size_t> bySymbolicName;
+  for (std::size_t i = 0; i < n; ++i) {
+    byFileName.insert(std::make_pair(GetFileName(bundles[i]->location), i));
+    bySymbolicName.insert(std::make_pair(bundles[i]->symbolicName, i));
+  }
+
+  std::vector<std::vector<std::size_t>> deps(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    auto add = [&deps, i](const auto& range) {
+      for (auto iter = range.first; iter != range.second; ++iter) {
+        if (iter->second != i) {
+          deps[i].push_back(iter->second);
+        }
+      }
+    };
+
+    auto& b = bundles[i];
+    if (b->barchive) {
+      for (auto& lib : b->barchive->GetResourceContainer()->GetDependencies()) {
+        add(byFileName.equal_range(GetFileName(lib)));
+      }
+    }
+
+    auto headers = b->GetHeaders();
+    auto required = headers.find(Constants::BUNDLE_REQUIRES);
+    if (required != headers.end()) {
+      try {
+        for (auto& name : ref_any_cast<std::vector<Any>>(required->second)) {
+          add(bySymbolicName.equal_range(any_cast<std::string>(name)));
+        }
+      } catch (const BadAnyCastException& ex) {
+        coreCtx->listeners.SendFrameworkEvent(FrameworkEvent(
+          FrameworkEvent::Type::FRAMEWORK_WARNING,
+          MakeBundle(b),
+          "Failed to read '" + Constants::BUNDLE_REQUIRES +
+            "' property. Expected a list of symbolic names.",
+          std::make_exception_ptr(ex)));
+      }
+    }
+
+    std::sort(deps[i].begin(), deps[i].end());
+    deps[i].erase(std::unique(deps[i].begin(), deps[i].end()), deps[i].end());
+  }
+
+  const auto component = GetComponents(deps);
+  for (std::size_t i = 0; i < n; ++i) {
+    auto inCycle = [i, &component](std::size_t j) {
+      return j > i && component[j] == component[i];
+    };
+    deps[i].erase(std::remove_if(deps[i].begin(), deps[i].end(), inCycle),
+                  deps[i].end());
+  }
+  return deps;
+}
+}
+
 FrameworkPrivate::FrameworkPrivate(CoreBundleContext* fwCtx)
   : BundlePrivate(fwCtx)
 {
@@ -147,6 +290,133 @@ FrameworkEvent FrameworkPrivate::WaitForStop(
                         stopEvent.excPtr);
 }
 
+std::vector<BundleStartTiming> FrameworkPrivate::StartBundles(
+  const std::vector<Bundle>& bundles,
+  uint32_t options)
+{
+  std::vector<std::shared_ptr<BundlePrivate>> privates;
+  for (auto& b : bundles) {
+    if (!b) {
+      throw std::logic_error("Invalid bundle");
+    }
+    privates.push_back(GetPrivate(b));
+  }
+
+  const std::size_t n = bundles.size();
+  const auto deps = GetStartDependencies(coreCtx, privates);
+
+  std::vector<BundleStartTiming> timings(n);
+  std::vector<std::vector<std::size_t>> dependents(n);
+  struct
+    : detail::MultiThreaded<detail::MutexLockingStrategy<>,
+                            detail::WaitCondition>
+  {
+    std::vector<std::size_t> pending;
+    std::set<std::size_t> ready;
+    std::size_t finished;
+  } schedule;
+  schedule.pending.resize(n);
+  schedule.finished = 0;
+
+  for (std::size_t i = 0; i < n; ++i) {
+    timings[i].bundle = bundles[i];
+    timings[i].critical = false;
+    for (auto j : deps[i]) {
+      timings[i].dependencies.push_back(bundles[j]);
+      dependents[j].push_back(i);
+    }
+    schedule.pending[i] = deps[i].size();
+    if (deps[i].empty()) {
+      schedule.ready.insert(i);
+    }
+  }
+
+  const auto batchBegin = std::chrono::steady_clock::now();
+  auto elapsed = [&batchBegin]() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - batchBegin);
+  };
+
+  // Start bundles as soon as all their dependencies have been started.
+  // Bundles with a lower index are preferred.
+  auto worker = [&]() {
+    auto l = schedule.Lock();
+    for (;;) {
+      schedule.Wait(l, [&schedule, n] {
+        return !schedule.ready.empty() || schedule.finished == n;
+      });
+      if (schedule.ready.empty()) {
+        return;
+      }
+      const std::size_t i = *schedule.ready.begin();
+      schedule.ready.erase(schedule.ready.begin());
+      l.UnLock();
+
+      auto& timing = timings[i];
+      timing.begin = elapsed();
+      bool skipped = false;
+      for (auto j : deps[i]) {
+        if (timings[j].error) {
+          skipped = true;
+          timing.error = std::make_exception_ptr(std::runtime_error(
+            "Bundle#" + util::ToString(privates[i]->id) +
+            " not started: dependency Bundle#" +
+            util::ToString(privates[j]->id) + " failed to start"));
+          break;
+        }
+      }
+      if (!timing.error) {
+        try {
+          timing.bundle.Start(options);
+        } catch (...) {
+          timing.error = std::current_exception();
+        }
+      }
+      timing.end = elapsed();
+      if (timing.error) {
+        coreCtx->listeners.SendFrameworkEvent(FrameworkEvent(
+          FrameworkEvent::Type::FRAMEWORK_ERROR,
+          timing.bundle,
+          skipped ? std::string("Bundle not started during StartBundles, "
+                                "a dependency failed to start")
+                  : std::string("Failed to start bundle during StartBundles"),
+          timing.error));
+      }
+
+      l.Lock();
+      ++schedule.finished;
+      for (auto k : dependents[i]) {
+        if (--schedule.pending[k] == 0) {
+          schedule.ready.insert(k);
+        }
+      }
+      schedule.NotifyAll();
+    }
+  };
+
+  RunConcurrently(n, worker);
+
+  // The critical path ends with the bundle which finished last and
+  // continues with the dependency which finished last.
+  auto finishedLater = [&timings](std::size_t a, std::size_t b) {
+    return timings[a].end < timings[b].end;
+  };
+  if (n > 0) {
+    std::size_t i = 0;
+    for (std::size_t k = 1; k < n; ++k) {
+      if (finishedLater(i, k)) {
+        i = k;
+      }
+    }
+    timings[i].critical = true;
+    while (!deps[i].empty()) {
+      i = *std::max_element(deps[i].begin(), deps[i].end(), finishedLater);
+      timings[i].critical = true;
+    }
+  }
+  return timings;
+}
+
 void FrameworkPrivate::Shutdown(bool restart)
 {
   auto l = Lock();
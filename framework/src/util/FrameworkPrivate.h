@@ -23,6 +23,7 @@ limitations under the License.
 #ifndef CPPMICROSERVICES_FRAMEWORKPRIVATE_H
 #define CPPMICROSERVICES_FRAMEWORKPRIVATE_H
 
+#include "cppmicroservices/Framework.h"
 #include "cppmicroservices/FrameworkEvent.h"
 
 #include "BundlePrivate.h"
@@ -30,6 +31,7 @@ limitations under the License.
 
 #include <map>
 #include <string>
+#include <vector>
 
 namespace cppmicroservices {
 
@@ -54,6 +56,10 @@ public:
 
   FrameworkEvent WaitForStop(const std::chrono::milliseconds& timeout);
 
+  std::vector<BundleStartTiming> StartBundles(
+    const std::vector<Bundle>& bundles,
+    uint32_t options);
+
   void Shutdown(bool restart);
 
   virtual void Start(uint32_t);
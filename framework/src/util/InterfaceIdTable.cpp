@@ -0,0 +1,85 @@
+/*=============================================================================
+
+  Library: CppMicroServices
+
+  Copyright (c) The CppMicroServices developers. See the COPYRIGHT
+  file at the top-level directory of this distribution and at
+  https://github.com/CppMicroServices/CppMicroServices/COPYRIGHT .
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#include "InterfaceIdTable.h"
+
+#include "cppmicroservices/ServiceInterface.h"
+
+namespace cppmicroservices {
+
+namespace detail {
+
+std::size_t GetInterfaceId(const std::string& interfaceName)
+{
+  return InterfaceIdTable::Global().GetId(interfaceName);
+}
+}
+
+InterfaceIdTable& InterfaceIdTable::Global()
+{
+  static InterfaceIdTable table;
+  return table;
+}
+
+InterfaceIdTable::InterfaceIdTable()
+{
+  ids.Store(std::make_shared<const Ids>());
+}
+
+std::size_t InterfaceIdTable::GetId(const std::string& name)
+{
+  std::size_t id = 0;
+  if (FindId(name, id)) {
+    return id;
+  }
+
+  auto l = this->Lock();
+  US_UNUSED(l);
+  // Another thread may have added the name in the meantime
+  auto current = ids.Load();
+  auto iter = current->find(name);
+  if (iter != current->end()) {
+    return iter->second;
+  }
+  auto next = std::make_shared<Ids>(*current);
+  id = next->size();
+  next->insert(std::make_pair(name, id));
+  ids.Store(std::move(next));
+  return id;
+}
+
+bool InterfaceIdTable::FindId(const std::string& name, std::size_t& id) const
+{
+  auto current = ids.Load();
+  auto iter = current->find(name);
+  if (iter == current->end()) {
+    return false;
+  }
+  id = iter->second;
+  return true;
+}
+
+std::size_t InterfaceIdTable::Size() const
+{
+  return ids.Load()->size();
+}
+}
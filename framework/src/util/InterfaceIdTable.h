@@ -0,0 +1,84 @@
+/*=============================================================================
+
+  Library: CppMicroServices
+
+  Copyright (c) The CppMicroServices developers. See the COPYRIGHT
+  file at the top-level directory of this distribution and at
+  https://github.com/CppMicroServices/CppMicroServices/COPYRIGHT .
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#ifndef CPPMICROSERVICES_INTERFACEIDTABLE_H
+#define CPPMICROSERVICES_INTERFACEIDTABLE_H
+
+#include "cppmicroservices/detail/Threads.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace cppmicroservices {
+
+/**
+ * A process wide table of interned service interface names.
+ *
+ * Each interface name is assigned a small integer id the first time it
+ * is seen. Ids are never reused or released, so they can be cached for
+ * the lifetime of the process, e.g. by us_service_interface_id<T>().
+ * Framework internal maps keyed by interface use these ids instead of
+ * hashing and comparing the (often long) interface names.
+ *
+ * Lookups read an immutable snapshot of the table without locking.
+ * Only assigning an id to a new name takes a lock and publishes a new
+ * snapshot.
+ *
+ * This class is not part of the public API.
+ */
+class InterfaceIdTable : private detail::MultiThreaded<>
+{
+
+public:
+
+  InterfaceIdTable(const InterfaceIdTable&) = delete;
+  InterfaceIdTable& operator=(const InterfaceIdTable&) = delete;
+
+  static InterfaceIdTable& Global();
+
+  InterfaceIdTable();
+
+  //! Return the id of \c name, assigning a new id if necessary.
+  std::size_t GetId(const std::string& name);
+
+  /**
+   * Look up the id of \c name without assigning a new one. Use this for
+   * names which are only looked for, e.g. in a filter, so they do not
+   * grow the table.
+   *
+   * @return \c true if \c name has an id, \c false otherwise.
+   */
+  bool FindId(const std::string& name, std::size_t& id) const;
+
+  //! Number of interned interface names.
+  std::size_t Size() const;
+
+private:
+  using Ids = std::unordered_map<std::string, std::size_t>;
+
+  //! The current snapshot, replaced whenever a name is added
+  detail::Atomic<std::shared_ptr<const Ids>> ids;
+};
+}
+
+#endif // CPPMICROSERVICES_INTERFACEIDTABLE_H
@@ -34,6 +34,8 @@
 #include <iterator>
 #include <limits>
 #include <stdexcept>
+#include <typeindex>
+#include <unordered_map>
 #include <utility>
 
 namespace cppmicroservices {
@@ -127,6 +129,217 @@ public:
   void error(const std::string& m) const;
 };
 
+namespace {
+
+//! Remove white space and convert to lower case.
+std::string FixupString(const std::string& s)
+{
+  std::string sb;
+  sb.reserve(s.size());
+  std::size_t len = s.length();
+  for (std::size_t i = 0; i < len; i++) {
+    char c = s.at(i);
+    if (!std::isspace(c)) {
+      if (std::isupper(c))
+        c = std::tolower(c);
+      sb.append(1, c);
+    }
+  }
+  return sb;
+}
+
+//! Equivalent to FixupString(s) == fixedUp, without allocating.
+bool EqualsFixedUp(const std::string& s, const std::string& fixedUp)
+{
+  std::size_t fi = 0;
+  for (char c : s) {
+    if (std::isspace(c))
+      continue;
+    if (fi == fixedUp.size() || std::tolower(c) != fixedUp[fi])
+      return false;
+    ++fi;
+  }
+  return fi == fixedUp.size();
+}
+
+/**
+ * A wildcard pattern, pre-compiled into the literal segments between
+ * wildcard characters.
+ *
+ * Matching is iterative: the first and last segments are anchored at
+ * the start and end of the string (unless the pattern starts or ends
+ * with a wildcard) and each remaining segment is matched greedily at
+ * its leftmost occurrence using a Knuth-Morris-Pratt search. The
+ * matching time is therefore linear in the length of the string and
+ * the pattern. Patterns of the form "abc", "abc*", "*abc" and "*abc*"
+ * use dedicated fast paths.
+ */
+class WildcardPattern
+{
+public:
+  WildcardPattern()
+    : m_kind(EXACT)
+    , m_anchorStart(true)
+    , m_anchorEnd(true)
+    , m_segments()
+    , m_failure()
+  {}
+
+  explicit WildcardPattern(const std::string& pat)
+    : WildcardPattern()
+  {
+    const char wildcard = LDAPExprConstants::WILDCARD();
+    m_anchorStart = pat.empty() || pat.front() != wildcard;
+    m_anchorEnd = pat.empty() || pat.back() != wildcard;
+
+    std::size_t start = 0;
+    bool hasWildcard = false;
+    for (;;) {
+      std::size_t pos = pat.find(wildcard, start);
+      std::string segment = pat.substr(start, pos - start);
+      if (!segment.empty()) {
+        m_segments.push_back(std::move(segment));
+      }
+      if (pos == std::string::npos)
+        break;
+      hasWildcard = true;
+      start = pos + 1;
+    }
+
+    if (!hasWildcard) {
+      m_kind = EXACT;
+      m_segments.assign(1, pat);
+    } else if (m_segments.empty()) {
+      m_kind = ANY;
+    } else if (m_segments.size() == 1) {
+      m_kind = m_anchorStart ? PREFIX : (m_anchorEnd ? SUFFIX : CONTAINS);
+    } else {
+      m_kind = GENERAL;
+    }
+
+    m_failure.reserve(m_segments.size());
+    for (const auto& segment : m_segments) {
+      m_failure.push_back(FailureTable(segment));
+    }
+  }
+
+  bool Match(const std::string& s) const
+  {
+    switch (m_kind) {
+      case EXACT:
+        return s == m_segments.front();
+      case ANY:
+        return true;
+      case PREFIX:
+        return StartsWith(s, 0, m_segments.front());
+      case SUFFIX:
+        return EndsWith(s, m_segments.front());
+      case CONTAINS:
+        return Find(s, 0, s.size(), 0) != std::string::npos;
+      default:
+        return MatchGeneral(s);
+    }
+  }
+
+private:
+  enum Kind
+  {
+    EXACT,
+    ANY,
+    PREFIX,
+    SUFFIX,
+    CONTAINS,
+    GENERAL
+  };
+
+  static bool StartsWith(const std::string& s,
+                         std::size_t pos,
+                         const std::string& segment)
+  {
+    return s.size() - pos >= segment.size() &&
+           s.compare(pos, segment.size(), segment) == 0;
+  }
+
+  static bool EndsWith(const std::string& s, const std::string& segment)
+  {
+    return s.size() >= segment.size() &&
+           s.compare(s.size() - segment.size(), segment.size(), segment) == 0;
+  }
+
+  static std::vector<std::size_t> FailureTable(const std::string& segment)
+  {
+    std::vector<std::size_t> table(segment.size(), 0);
+    std::size_t k = 0;
+    for (std::size_t i = 1; i < segment.size(); ++i) {
+      while (k > 0 && segment[i] != segment[k])
+        k = table[k - 1];
+      if (segment[i] == segment[k])
+        ++k;
+      table[i] = k;
+    }
+    return table;
+  }
+
+  /**
+   * Find the leftmost occurrence of segment \a si in s[begin, end).
+   * Returns the position after the occurrence or std::string::npos.
+   */
+  std::size_t Find(const std::string& s,
+                   std::size_t begin,
+                   std::size_t end,
+                   std::size_t si) const
+  {
+    const std::string& segment = m_segments[si];
+    const std::vector<std::size_t>& table = m_failure[si];
+    std::size_t k = 0;
+    for (std::size_t i = begin; i < end; ++i) {
+      while (k > 0 && s[i] != segment[k])
+        k = table[k - 1];
+      if (s[i] == segment[k])
+        ++k;
+      if (k == segment.size())
+        return i + 1;
+    }
+    return std::string::npos;
+  }
+
+  bool MatchGeneral(const std::string& s) const
+  {
+    std::size_t first = 0;
+    std::size_t last = m_segments.size();
+    std::size_t pos = 0;
+    std::size_t end = s.size();
+
+    if (m_anchorStart) {
+      if (!StartsWith(s, 0, m_segments.front()))
+        return false;
+      pos = m_segments.front().size();
+      ++first;
+    }
+    if (m_anchorEnd) {
+      const std::string& segment = m_segments.back();
+      if (end - pos < segment.size() || !EndsWith(s, segment))
+        return false;
+      end -= segment.size();
+      --last;
+    }
+
+    for (std::size_t si = first; si < last; ++si) {
+      pos = Find(s, pos, end, si);
+      if (pos == std::string::npos)
+        return false;
+    }
+    return true;
+  }
+
+  Kind m_kind;
+  bool m_anchorStart;
+  bool m_anchorEnd;
+  std::vector<std::string> m_segments;
+  std::vector<std::vector<std::size_t>> m_failure;
+};
+}
+
 class LDAPExprData : public SharedData
 {
 public:
@@ -135,6 +348,15 @@ public:
     , m_args(std::move(args))
     , m_attrName()
     , m_attrValue()
+    , m_isWildcard(false)
+    , m_hasLong(false)
+    , m_longValue(0)
+    , m_hasDouble(false)
+    , m_doubleValue(0)
+    , m_matchesTrue(false)
+    , m_matchesFalse(false)
+    , m_pattern()
+    , m_approxValue()
   {}
 
   LDAPExprData(int op, std::string attrName, std::string  attrValue)
@@ -142,7 +364,18 @@ public:
     , m_args()
     , m_attrName(std::move(attrName))
     , m_attrValue(std::move(attrValue))
-  {}
+    , m_isWildcard(false)
+    , m_hasLong(false)
+    , m_longValue(0)
+    , m_hasDouble(false)
+    , m_doubleValue(0)
+    , m_matchesTrue(false)
+    , m_matchesFalse(false)
+    , m_pattern()
+    , m_approxValue()
+  {
+    ParseAttrValue();
+  }
 
   LDAPExprData(const LDAPExprData& other)
      
@@ -152,6 +385,189 @@ public:
   std::vector<LDAPExpr> m_args;
   std::string m_attrName;
   std::string m_attrValue;
+
+  // Typed representations of m_attrValue. They are computed once when
+  // the expression is parsed, so that evaluating the expression against
+  // numeric or boolean properties does not need any string conversions.
+  bool m_isWildcard;
+  bool m_hasLong;
+  long m_longValue;
+  bool m_hasDouble;
+  double m_doubleValue;
+  bool m_matchesTrue;
+  bool m_matchesFalse;
+  WildcardPattern m_pattern;
+  std::string m_approxValue;
+
+private:
+  void ParseAttrValue()
+  {
+    const std::string& s = m_attrValue;
+    m_isWildcard = (s == LDAPExprConstants::WILDCARD_STRING());
+
+    errno = 0;
+    char* endptr = nullptr;
+    long longInt = strtol(s.c_str(), &endptr, 10);
+    m_hasLong =
+      !((errno == ERANGE && (longInt == std::numeric_limits<long>::max() ||
+                             longInt == std::numeric_limits<long>::min())) ||
+        (errno != 0 && longInt == 0) || endptr == s.c_str());
+    m_longValue = longInt;
+
+    errno = 0;
+    endptr = nullptr;
+    double sDouble = strtod(s.c_str(), &endptr);
+    m_hasDouble =
+      !((errno == ERANGE &&
+         (sDouble == 0 || sDouble == HUGE_VAL || sDouble == -HUGE_VAL)) ||
+        (errno != 0 && sDouble == 0) || endptr == s.c_str());
+    m_doubleValue = sDouble;
+
+    m_matchesTrue = MatchesBoolString(s, "true");
+    m_matchesFalse = MatchesBoolString(s, "false");
+
+    if (m_operator == LDAPExpr::EQ) {
+      m_pattern = WildcardPattern(s);
+    } else if (m_operator == LDAPExpr::APPROX) {
+      m_approxValue = FixupString(s);
+    }
+  }
+
+  // Boolean properties match any case-insensitive prefix of their
+  // string representation.
+  static bool MatchesBoolString(const std::string& s,
+                                const std::string& boolVal)
+  {
+    return s.size() <= boolVal.size() &&
+           std::equal(s.begin(), s.end(), boolVal.begin(), stricomp);
+  }
+};
+
+/**
+ * Type specific comparison functions for simple expressions, keyed by
+ * the type of the property value. Looking up the comparator replaces
+ * a chain of typeid comparisons on every evaluated property.
+ */
+class LDAPExpr::Comparators
+{
+public:
+  using Comparator = bool (*)(const LDAPExpr& expr, const Any& obj);
+
+  //! Returns the comparator for \a type, or nullptr if it is not supported.
+  static Comparator Get(const std::type_info& type)
+  {
+    static const std::unordered_map<std::type_index, Comparator> table = {
+      { typeid(std::string), &CompareStringValue },
+      { typeid(std::vector<std::string>),
+        &CompareStringList<std::vector<std::string>> },
+      { typeid(std::list<std::string>),
+        &CompareStringList<std::list<std::string>> },
+      { typeid(char), &CompareChar },
+      { typeid(bool), &CompareBool },
+      { typeid(short), &CompareIntegral<short> },
+      { typeid(int), &CompareIntegral<int> },
+      { typeid(long int), &CompareIntegral<long int> },
+      { typeid(long long int), &CompareIntegral<long long int> },
+      { typeid(unsigned char), &CompareIntegral<unsigned char> },
+      { typeid(unsigned short), &CompareIntegral<unsigned short> },
+      { typeid(unsigned int), &CompareIntegral<unsigned int> },
+      { typeid(unsigned long int), &CompareIntegral<unsigned long int> },
+      { typeid(unsigned long long int),
+        &CompareIntegral<unsigned long long int> },
+      { typeid(float), &CompareFloatingPoint<float> },
+      { typeid(double), &CompareFloatingPoint<double> },
+      { typeid(std::vector<Any>), &CompareAnyList }
+    };
+
+    auto iter = table.find(std::type_index(type));
+    return iter == table.end() ? nullptr : iter->second;
+  }
+
+private:
+  // The comparator table already checked the type of obj
+  template<typename T>
+  static const T& Held(const Any& obj)
+  {
+    return *unsafe_any_cast<T>(const_cast<Any*>(&obj));
+  }
+
+  static bool CompareStringValue(const LDAPExpr& expr, const Any& obj)
+  {
+    return expr.CompareString(Held<std::string>(obj));
+  }
+
+  template<typename List>
+  static bool CompareStringList(const LDAPExpr& expr, const Any& obj)
+  {
+    for (const auto& str : Held<List>(obj)) {
+      if (expr.CompareString(str))
+        return true;
+    }
+    return false;
+  }
+
+  static bool CompareChar(const LDAPExpr& expr, const Any& obj)
+  {
+    return expr.CompareString(std::string(1, Held<char>(obj)));
+  }
+
+  static bool CompareBool(const LDAPExpr& expr, const Any& obj)
+  {
+    const int op = expr.d->m_operator;
+    if (op == LE || op == GE)
+      return false;
+
+    return Held<bool>(obj) ? expr.d->m_matchesTrue : expr.d->m_matchesFalse;
+  }
+
+  template<typename T>
+  static bool CompareIntegral(const LDAPExpr& expr, const Any& obj)
+  {
+    if (!expr.d->m_hasLong)
+      return false;
+
+    auto sInt = static_cast<T>(expr.d->m_longValue);
+    auto intVal = Held<T>(obj);
+
+    switch (expr.d->m_operator) {
+      case LE:
+        return intVal <= sInt;
+      case GE:
+        return intVal >= sInt;
+      default: /*APPROX and EQ*/
+        return intVal == sInt;
+    }
+  }
+
+  template<typename T>
+  static bool CompareFloatingPoint(const LDAPExpr& expr, const Any& obj)
+  {
+    if (!expr.d->m_hasDouble)
+      return false;
+
+    const double sDouble = expr.d->m_doubleValue;
+    auto doubleVal = static_cast<double>(Held<T>(obj));
+
+    switch (expr.d->m_operator) {
+      case LE:
+        return doubleVal <= sDouble;
+      case GE:
+        return doubleVal >= sDouble;
+      default: /*APPROX and EQ*/
+        double diff = doubleVal - sDouble;
+        return (diff < std::numeric_limits<T>::epsilon()) &&
+               (diff > -std::numeric_limits<T>::epsilon());
+    }
+  }
+
+  static bool CompareAnyList(const LDAPExpr& expr, const Any& obj)
+  {
+    for (const auto& item : Held<std::vector<Any>>(obj)) {
+      if (expr.Compare(item))
+        return true;
+    }
+    return false;
+  }
 };
 
 LDAPExpr::LDAPExpr()
@@ -282,7 +698,7 @@ bool LDAPExpr::IsSimple(const StringList& keywords,
           keywords.end() &&
         d->m_attrValue.find_first_of(LDAPExprConstants::WILDCARD()) ==
           std::string::npos) {
-      cache[index - keywords.begin()] = StringList(1, d->m_attrValue);
+      cache[index - keywords.begin()].push_back(d->m_attrValue);
       return true;
     }
   } else if (d->m_operator == OR) {
@@ -309,7 +725,7 @@ bool LDAPExpr::Evaluate(const PropertiesHandle& p, bool matchCase) const
       index = p->Find_unlocked(d->m_attrName);
     return index < 0
              ? false
-             : Compare(p->Value_unlocked(index), d->m_operator, d->m_attrValue);
+             : Compare(p->Value_unlocked(index));
   } else { // (d->m_operator & COMPLEX) != 0
     switch (d->m_operator) {
       case AND:
@@ -332,208 +748,42 @@ bool LDAPExpr::Evaluate(const PropertiesHandle& p, bool matchCase) const
   }
 }
 
-bool LDAPExpr::Compare(const Any& obj, int op, const std::string& s) const
+bool LDAPExpr::Compare(const Any& obj) const
 {
   if (obj.Empty())
     return false;
-  if (op == EQ && s == LDAPExprConstants::WILDCARD_STRING())
+  if (d->m_operator == EQ && d->m_isWildcard)
     return true;
 
-  try {
-    const std::type_info& objType = obj.Type();
-    if (objType == typeid(std::string)) {
-      return CompareString(ref_any_cast<std::string>(obj), op, s);
-    } else if (objType == typeid(std::vector<std::string>)) {
-      const auto& list =
-        ref_any_cast<std::vector<std::string>>(obj);
-      for (std::size_t it = 0; it != list.size(); it++) {
-        if (CompareString(list[it], op, s))
-          return true;
-      }
-    } else if (objType == typeid(std::list<std::string>)) {
-      const auto& list =
-        ref_any_cast<std::list<std::string>>(obj);
-      for (const auto & it : list) {
-        if (CompareString(it, op, s))
-          return true;
-      }
-    } else if (objType == typeid(char)) {
-      return CompareString(std::string(1, ref_any_cast<char>(obj)), op, s);
-    } else if (objType == typeid(bool)) {
-      if (op == LE || op == GE)
-        return false;
-
-      std::string boolVal = any_cast<bool>(obj) ? "true" : "false";
-      return std::equal(s.begin(), s.end(), boolVal.begin(), stricomp);
-    } else if (objType == typeid(short)) {
-      return CompareIntegralType<short>(obj, op, s);
-    } else if (objType == typeid(int)) {
-      return CompareIntegralType<int>(obj, op, s);
-    } else if (objType == typeid(long int)) {
-      return CompareIntegralType<long int>(obj, op, s);
-    } else if (objType == typeid(long long int)) {
-      return CompareIntegralType<long long int>(obj, op, s);
-    } else if (objType == typeid(unsigned char)) {
-      return CompareIntegralType<unsigned char>(obj, op, s);
-    } else if (objType == typeid(unsigned short)) {
-      return CompareIntegralType<unsigned short>(obj, op, s);
-    } else if (objType == typeid(unsigned int)) {
-      return CompareIntegralType<unsigned int>(obj, op, s);
-    } else if (objType == typeid(unsigned long int)) {
-      return CompareIntegralType<unsigned long int>(obj, op, s);
-    } else if (objType == typeid(unsigned long long int)) {
-      return CompareIntegralType<unsigned long long int>(obj, op, s);
-    } else if (objType == typeid(float)) {
-      errno = 0;
-      char* endptr = nullptr;
-      double sFloat = strtod(s.c_str(), &endptr);
-      if ((errno == ERANGE &&
-           (sFloat == 0 || sFloat == HUGE_VAL || sFloat == -HUGE_VAL)) ||
-          (errno != 0 && sFloat == 0) || endptr == s.c_str()) {
-        return false;
-      }
-
-      auto floatVal = static_cast<double>(any_cast<float>(obj));
-
-      switch (op) {
-        case LE:
-          return floatVal <= sFloat;
-        case GE:
-          return floatVal >= sFloat;
-        default: /*APPROX and EQ*/
-          double diff = floatVal - sFloat;
-          return (diff < std::numeric_limits<float>::epsilon()) &&
-                 (diff > -std::numeric_limits<float>::epsilon());
-      }
-    } else if (objType == typeid(double)) {
-      errno = 0;
-      char* endptr = nullptr;
-      double sDouble = strtod(s.c_str(), &endptr);
-      if ((errno == ERANGE &&
-           (sDouble == 0 || sDouble == HUGE_VAL || sDouble == -HUGE_VAL)) ||
-          (errno != 0 && sDouble == 0) || endptr == s.c_str()) {
-        return false;
-      }
+  Comparators::Comparator comparator = Comparators::Get(obj.Type());
+  if (comparator == nullptr)
+    return false;
 
-      auto doubleVal = any_cast<double>(obj);
-
-      switch (op) {
-        case LE:
-          return doubleVal <= sDouble;
-        case GE:
-          return doubleVal >= sDouble;
-        default: /*APPROX and EQ*/
-          double diff = doubleVal - sDouble;
-          return (diff < std::numeric_limits<double>::epsilon()) &&
-                 (diff > -std::numeric_limits<double>::epsilon());
-      }
-    } else if (objType == typeid(std::vector<Any>)) {
-      const auto& list = ref_any_cast<std::vector<Any>>(obj);
-      for (std::size_t it = 0; it != list.size(); it++) {
-        if (Compare(list[it], op, s))
-          return true;
-      }
-    }
+  try {
+    return comparator(*this, obj);
   } catch (...) {
-    // This might happen if a std::string-to-datatype conversion fails
+    // Comparing strings might throw (e.g. std::bad_alloc).
     // Just consider it a false match and ignore the exception
   }
   return false;
 }
 
-template<typename T>
-bool LDAPExpr::CompareIntegralType(const Any& obj,
-                                   const int op,
-                                   const std::string& s) const
-{
-  errno = 0;
-  char* endptr = nullptr;
-  long longInt = strtol(s.c_str(), &endptr, 10);
-  if ((errno == ERANGE && (longInt == std::numeric_limits<long>::max() ||
-                           longInt == std::numeric_limits<long>::min())) ||
-      (errno != 0 && longInt == 0) || endptr == s.c_str()) {
-    return false;
-  }
-
-  auto sInt = static_cast<T>(longInt);
-  auto intVal = any_cast<T>(obj);
-
-  switch (op) {
-    case LE:
-      return intVal <= sInt;
-    case GE:
-      return intVal >= sInt;
-    default: /*APPROX and EQ*/
-      return intVal == sInt;
-  }
-}
-
-bool LDAPExpr::CompareString(const std::string& s1,
-                             int op,
-                             const std::string& s2)
+bool LDAPExpr::CompareString(const std::string& s) const
 {
-  switch (op) {
+  switch (d->m_operator) {
     case LE:
-      return s1.compare(s2) <= 0;
+      return s.compare(d->m_attrValue) <= 0;
     case GE:
-      return s1.compare(s2) >= 0;
+      return s.compare(d->m_attrValue) >= 0;
     case EQ:
-      return PatSubstr(s1, s2);
+      return d->m_pattern.Match(s);
     case APPROX:
-      return FixupString(s2) == FixupString(s1);
+      return EqualsFixedUp(s, d->m_approxValue);
     default:
       return false;
   }
 }
 
-std::string LDAPExpr::FixupString(const std::string& s)
-{
-  std::string sb;
-  sb.reserve(s.size());
-  std::size_t len = s.length();
-  for (std::size_t i = 0; i < len; i++) {
-    char c = s.at(i);
-    if (!std::isspace(c)) {
-      if (std::isupper(c))
-        c = std::tolower(c);
-      sb.append(1, c);
-    }
-  }
-  return sb;
-}
-
-bool LDAPExpr::PatSubstr(const std::string& s,
-                         int si,
-                         const std::string& pat,
-                         int pi)
-{
-  if (pat.size() - pi == 0)
-    return s.size() - si == 0;
-  if (pat[pi] == LDAPExprConstants::WILDCARD()) {
-    pi++;
-    for (;;) {
-      if (PatSubstr(s, si, pat, pi))
-        return true;
-      if (s.size() - si == 0)
-        return false;
-      si++;
-    }
-  } else {
-    if (s.size() - si == 0) {
-      return false;
-    }
-    if (s[si] != pat[pi]) {
-      return false;
-    }
-    return PatSubstr(s, ++si, pat, ++pi);
-  }
-}
-
-bool LDAPExpr::PatSubstr(const std::string& s, const std::string& pat)
-{
-  return PatSubstr(s, 0, pat, 0);
-}
-
 LDAPExpr LDAPExpr::ParseExpr(ParseState& ps)
 {
   ps.skipWhite();
@@ -125,6 +125,7 @@ public:
 
 private:
   class ParseState;
+  class Comparators;
 
   //!
   LDAPExpr(int op, const std::vector<LDAPExpr>& args);
@@ -142,31 +143,14 @@ private:
 
   static std::string ToLower(const std::string& str);
 
-  //!
-  bool Compare(const Any& obj, int op, const std::string& s) const;
-
-  //!
-  template<typename T>
-  bool CompareIntegralType(const Any& obj,
-                           const int op,
-                           const std::string& s) const;
-
-  //!
-  static bool CompareString(const std::string& s1,
-                            int op,
-                            const std::string& s2);
-
-  //!
-  static std::string FixupString(const std::string& s);
-
-  //!
-  static bool PatSubstr(const std::string& s, const std::string& pat);
+  /**
+   * Compare \a obj with the pre-parsed attribute value of this simple
+   * expression, using the comparator registered for the type of \a obj.
+   */
+  bool Compare(const Any& obj) const;
 
-  //!
-  static bool PatSubstr(const std::string& s,
-                        int si,
-                        const std::string& pat,
-                        int pi);
+  //! Compare \a s with the attribute value of this simple expression.
+  bool CompareString(const std::string& s) const;
 
   //! Shared pointer
   SharedDataPointer<LDAPExprData> d;
@@ -0,0 +1,108 @@
+/*=============================================================================
+
+  Library: CppMicroServices
+
+  Copyright (c) The CppMicroServices developers. See the COPYRIGHT
+  file at the top-level directory of this distribution and at
+  https://github.com/CppMicroServices/CppMicroServices/COPYRIGHT .
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#include "LDAPExprCache.h"
+
+namespace cppmicroservices {
+
+const std::size_t LDAPExprCache::DEFAULT_CAPACITY = 1024;
+
+LDAPExprCache::LDAPExprCache(std::size_t capacity)
+  : capacity(capacity > 0 ? capacity : 1)
+  , lru()
+  , index()
+  , hits(0)
+  , misses(0)
+{}
+
+LDAPExprCache& LDAPExprCache::Global()
+{
+  static LDAPExprCache cache;
+  return cache;
+}
+
+LDAPExpr LDAPExprCache::Get(const std::string& filter)
+{
+  {
+    auto l = this->Lock();
+    US_UNUSED(l);
+    auto iter = index.find(filter);
+    if (iter != index.end()) {
+      ++hits;
+      lru.splice(lru.begin(), lru, iter->second);
+      return iter->second->second;
+    }
+  }
+
+  ++misses;
+
+  // Parse without holding the lock, so that a slow parse does not
+  // block lookups of already cached filters. This throws for invalid
+  // filters, which are therefore never cached.
+  LDAPExpr expr(filter);
+
+  auto l = this->Lock();
+  US_UNUSED(l);
+  auto iter = index.find(filter);
+  if (iter != index.end()) {
+    // another thread cached the same filter in the meantime
+    lru.splice(lru.begin(), lru, iter->second);
+    return iter->second->second;
+  }
+
+  if (lru.size() >= capacity) {
+    index.erase(lru.back().first);
+    lru.pop_back();
+  }
+  lru.emplace_front(filter, expr);
+  index.insert(std::make_pair(filter, lru.begin()));
+  return expr;
+}
+
+void LDAPExprCache::Clear()
+{
+  auto l = this->Lock();
+  US_UNUSED(l);
+  index.clear();
+  lru.clear();
+}
+
+std::size_t LDAPExprCache::Size() const
+{
+  return this->Lock(), lru.size();
+}
+
+std::size_t LDAPExprCache::Capacity() const
+{
+  return capacity;
+}
+
+std::size_t LDAPExprCache::Hits() const
+{
+  return hits;
+}
+
+std::size_t LDAPExprCache::Misses() const
+{
+  return misses;
+}
+}
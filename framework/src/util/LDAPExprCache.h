@@ -0,0 +1,105 @@
+/*=============================================================================
+
+  Library: CppMicroServices
+
+  Copyright (c) The CppMicroServices developers. See the COPYRIGHT
+  file at the top-level directory of this distribution and at
+  https://github.com/CppMicroServices/CppMicroServices/COPYRIGHT .
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#ifndef CPPMICROSERVICES_LDAPEXPRCACHE_H
+#define CPPMICROSERVICES_LDAPEXPRCACHE_H
+
+#include "cppmicroservices/detail/Threads.h"
+
+#include "LDAPExpr.h"
+
+#include <atomic>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace cppmicroservices {
+
+/**
+ * A bounded, thread-safe cache mapping LDAP filter strings to their
+ * parsed LDAPExpr representation.
+ *
+ * Parsed expressions are immutable and implicitly shared, so a cache
+ * hit only costs a hash lookup and a reference count increment instead
+ * of a full parse. When the cache is full, the least recently used
+ * entry is evicted. Filters which fail to parse are not cached.
+ *
+ * This class is not part of the public API.
+ */
+class LDAPExprCache : private detail::MultiThreaded<>
+{
+
+public:
+  static const std::size_t DEFAULT_CAPACITY;
+
+  explicit LDAPExprCache(std::size_t capacity = DEFAULT_CAPACITY);
+
+  LDAPExprCache(const LDAPExprCache&) = delete;
+  LDAPExprCache& operator=(const LDAPExprCache&) = delete;
+
+  /**
+   * The process wide cache shared by the service registry, service
+   * listeners and LDAPFilter objects.
+   */
+  static LDAPExprCache& Global();
+
+  /**
+   * Return the parsed expression for \c filter, parsing and caching it
+   * if it is not already cached.
+   *
+   * @throws std::invalid_argument if \c filter is not a valid LDAP filter.
+   */
+  LDAPExpr Get(const std::string& filter);
+
+  //! Remove all cached entries. Hit and miss counters are not reset.
+  void Clear();
+
+  std::size_t Size() const;
+
+  std::size_t Capacity() const;
+
+  //! Number of Get() calls which were served from the cache.
+  std::size_t Hits() const;
+
+  //! Number of Get() calls which required parsing the filter.
+  std::size_t Misses() const;
+
+private:
+  using LruList = std::list<std::pair<std::string, LDAPExpr>>;
+
+  const std::size_t capacity;
+
+  /**
+   * Cached entries, ordered from most recently used to least
+   * recently used.
+   */
+  LruList lru;
+
+  std::unordered_map<std::string, LruList::iterator> index;
+
+  std::atomic<std::size_t> hits;
+  std::atomic<std::size_t> misses;
+};
+}
+
+#endif // CPPMICROSERVICES_LDAPEXPRCACHE_H
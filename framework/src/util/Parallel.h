@@ -0,0 +1,87 @@
+/*=============================================================================
+
+  Library: CppMicroServices
+
+  Copyright (c) The CppMicroServices developers. See the COPYRIGHT
+  file at the top-level directory of this distribution and at
+  https://github.com/CppMicroServices/CppMicroServices/COPYRIGHT .
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#ifndef CPPMICROSERVICES_PARALLEL_H
+#define CPPMICROSERVICES_PARALLEL_H
+
+#include "cppmicroservices/GlobalConfig.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace cppmicroservices {
+
+/**
+ * Run \c worker concurrently on up to \c maxThreads threads, but not on
+ * more threads than there are hardware threads, and return when all of
+ * them returned. The calling thread is one of them. If no more threads
+ * can be created, \c worker runs on the threads created so far. Without
+ * threading support, \c worker runs once on the calling thread.
+ *
+ * \c worker must not throw.
+ */
+template<class Worker>
+void RunConcurrently(std::size_t maxThreads, Worker worker)
+{
+#ifdef US_ENABLE_THREADING_SUPPORT
+  const std::size_t numThreads = std::min<std::size_t>(
+    maxThreads, std::max(1u, std::thread::hardware_concurrency()));
+  std::vector<std::thread> threads;
+  threads.reserve(numThreads > 0 ? numThreads - 1 : 0);
+  for (std::size_t t = 1; t < numThreads; ++t) {
+    try {
+      threads.emplace_back(std::ref(worker));
+    } catch (const std::system_error&) {
+      break;
+    }
+  }
+  worker();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+#else
+  US_UNUSED(maxThreads);
+  worker();
+#endif
+}
+
+/**
+ * Call task(i) for all i in [0, n), distributed over the threads of
+ * RunConcurrently(). \c task must not throw.
+ */
+template<class Task>
+void ParallelFor(std::size_t n, Task task)
+{
+  std::atomic<std::size_t> next(0);
+  RunConcurrently(n, [&next, n, &task]() {
+    for (std::size_t i = next++; i < n; i = next++) {
+      task(i);
+    }
+  });
+}
+}
+
+#endif // CPPMICROSERVICES_PARALLEL_H
@@ -22,6 +22,10 @@
 
 #include "Properties.h"
 
+#include "cppmicroservices/Constants.h"
+
+#include <algorithm>
+#include <iterator>
 #include <limits>
 #include <stdexcept>
 #ifdef US_PLATFORM_WINDOWS
@@ -42,33 +46,46 @@ Properties::Properties(const AnyMap& p)
     throw std::runtime_error("Properties contain too many keys");
   }
 
+  std::fill(std::begin(wellKnown), std::end(wellKnown), -1);
+
   keys.reserve(p.size());
   values.reserve(p.size());
+  hashes.reserve(p.size());
+  if (!p.empty()) {
+    std::size_t indexSize = 8;
+    while (indexSize < 2 * p.size()) {
+      indexSize <<= 1;
+    }
+    index.assign(indexSize, -1);
+  }
 
   for (auto& iter : p) {
-    if (Find_unlocked(iter.first) > -1) {
-      std::string msg("Properties contain case variants of the key: ");
-      msg += iter.first;
-      throw std::runtime_error(msg.c_str());
-    }
-    keys.push_back(iter.first);
-    values.push_back(iter.second);
+    Insert(iter.first, iter.second);
   }
 }
 
 Properties::Properties(Properties&& o)
   : keys(std::move(o.keys))
   , values(std::move(o.values))
-{}
+  , hashes(std::move(o.hashes))
+  , index(std::move(o.index))
+{
+  std::copy(std::begin(o.wellKnown), std::end(o.wellKnown), wellKnown);
+  std::fill(std::begin(o.wellKnown), std::end(o.wellKnown), -1);
+}
 
 Properties& Properties::operator=(Properties&& o)
 {
   keys = std::move(o.keys);
   values = std::move(o.values);
+  hashes = std::move(o.hashes);
+  index = std::move(o.index);
+  std::copy(std::begin(o.wellKnown), std::end(o.wellKnown), wellKnown);
+  std::fill(std::begin(o.wellKnown), std::end(o.wellKnown), -1);
   return *this;
 }
 
-Any Properties::Value_unlocked(const std::string& key) const
+const Any& Properties::Value_unlocked(const std::string& key) const
 {
   int i = Find_unlocked(key);
   if (i < 0) {
@@ -77,7 +94,7 @@ Any Properties::Value_unlocked(const std::string& key) const
   return values[i];
 }
 
-Any Properties::Value_unlocked(int index) const
+const Any& Properties::Value_unlocked(int index) const
 {
   if (index < 0 || static_cast<std::size_t>(index) >= values.size()) {
     return emptyAny;
@@ -87,21 +104,21 @@ Any Properties::Value_unlocked(int index) const
 
 int Properties::Find_unlocked(const std::string& key) const
 {
-  for (std::size_t i = 0; i < keys.size(); ++i) {
-    if (key.size() == keys[i].size() &&
-        ci_compare(key.c_str(), keys[i].c_str(), key.size()) == 0) {
-      return static_cast<int>(i);
-    }
+  int w = WellKnownKeyIndex(key);
+  if (w >= 0) {
+    return wellKnown[w];
   }
-  return -1;
+  return FindSlot_unlocked(key, CaseFoldedHash(key));
 }
 
 int Properties::FindCaseSensitive_unlocked(const std::string& key) const
 {
-  for (std::size_t i = 0; i < keys.size(); ++i) {
-    if (key == keys[i]) {
-      return static_cast<int>(i);
-    }
+  // Keys which only differ in case are rejected on construction, so
+  // there is at most one case-insensitive match to check.
+  int w = WellKnownKeyIndex(key);
+  int i = (w >= 0) ? wellKnown[w] : FindSlot_unlocked(key, CaseFoldedHash(key));
+  if (i >= 0 && keys[static_cast<std::size_t>(i)] == key) {
+    return i;
   }
   return -1;
 }
@@ -115,5 +132,97 @@ void Properties::Clear_unlocked()
 {
   keys.clear();
   values.clear();
+  hashes.clear();
+  index.clear();
+  std::fill(std::begin(wellKnown), std::end(wellKnown), -1);
+}
+
+int Properties::WellKnownKeyIndex(const std::string& key)
+{
+  // Only the Constants objects themselves take the fast path, which
+  // makes the check a pointer comparison.
+  if (&key == &Constants::OBJECTCLASS) {
+    return OBJECTCLASS_KEY;
+  } else if (&key == &Constants::SERVICE_ID) {
+    return SERVICE_ID_KEY;
+  } else if (&key == &Constants::SERVICE_RANKING) {
+    return SERVICE_RANKING_KEY;
+  } else if (&key == &Constants::SERVICE_SCOPE) {
+    return SERVICE_SCOPE_KEY;
+  }
+  return -1;
+}
+
+std::size_t Properties::CaseFoldedHash(const std::string& key)
+{
+  // FNV-1a over the ASCII lower case characters
+  std::uint64_t hash = 14695981039346656037ULL;
+  for (char c : key) {
+    if (c >= 'A' && c <= 'Z') {
+      c = static_cast<char>(c - 'A' + 'a');
+    }
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ULL;
+  }
+  return static_cast<std::size_t>(hash);
+}
+
+void Properties::Insert(const std::string& key, const Any& value)
+{
+  const std::size_t hash = CaseFoldedHash(key);
+  if (FindSlot_unlocked(key, hash) > -1) {
+    std::string msg("Properties contain case variants of the key: ");
+    msg += key;
+    throw std::runtime_error(msg.c_str());
+  }
+
+  const auto i = static_cast<std::int32_t>(keys.size());
+  const std::size_t mask = index.size() - 1;
+  std::size_t slot = hash & mask;
+  while (index[slot] != -1) {
+    slot = (slot + 1) & mask;
+  }
+  index[slot] = i;
+
+  keys.push_back(key);
+  values.push_back(value);
+  hashes.push_back(hash);
+
+  static const std::string* const wellKnownKeys[NUM_WELL_KNOWN_KEYS] = {
+    &Constants::OBJECTCLASS,
+    &Constants::SERVICE_ID,
+    &Constants::SERVICE_RANKING,
+    &Constants::SERVICE_SCOPE
+  };
+  for (int w = 0; w < NUM_WELL_KNOWN_KEYS; ++w) {
+    const std::string& wellKnownKey = *wellKnownKeys[w];
+    if (key.size() == wellKnownKey.size() &&
+        ci_compare(key.c_str(), wellKnownKey.c_str(), key.size()) == 0) {
+      wellKnown[w] = i;
+      break;
+    }
+  }
+}
+
+int Properties::FindSlot_unlocked(const std::string& key,
+                                  std::size_t hash) const
+{
+  if (index.empty()) {
+    return -1;
+  }
+
+  const std::size_t mask = index.size() - 1;
+  for (std::size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+    const std::int32_t i = index[slot];
+    if (i < 0) {
+      return -1;
+    }
+    const std::string& candidate = keys[static_cast<std::size_t>(i)];
+    if (hashes[static_cast<std::size_t>(i)] == hash &&
+        key.size() == candidate.size() &&
+        ci_compare(key.c_str(), candidate.c_str(), key.size()) == 0) {
+      return i;
+    }
+  }
 }
 }
@@ -27,6 +27,7 @@
 #include "cppmicroservices/AnyMap.h"
 #include "cppmicroservices/detail/Threads.h"
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -41,8 +42,12 @@ public:
   Properties(Properties&& o);
   Properties& operator=(Properties&& o);
 
-  Any Value_unlocked(const std::string& key) const;
-  Any Value_unlocked(int index) const;
+  /**
+   * The returned reference is only valid while the lock is held and
+   * these properties are not modified or reassigned.
+   */
+  const Any& Value_unlocked(const std::string& key) const;
+  const Any& Value_unlocked(int index) const;
 
   int Find_unlocked(const std::string& key) const;
   int FindCaseSensitive_unlocked(const std::string& key) const;
@@ -52,12 +57,51 @@ public:
   void Clear_unlocked();
 
 private:
+  /**
+   * Well-known keys which are looked up on hot paths. Lookups which
+   * pass the corresponding Constants object itself use a fixed slot
+   * instead of the hash index.
+   */
+  enum WellKnownKey
+  {
+    OBJECTCLASS_KEY,
+    SERVICE_ID_KEY,
+    SERVICE_RANKING_KEY,
+    SERVICE_SCOPE_KEY,
+    NUM_WELL_KNOWN_KEYS
+  };
+
+  static int WellKnownKeyIndex(const std::string& key);
+
+  static std::size_t CaseFoldedHash(const std::string& key);
+
+  void Insert(const std::string& key, const Any& value);
+
+  int FindSlot_unlocked(const std::string& key, std::size_t hash) const;
+
   std::vector<std::string> keys;
   std::vector<Any> values;
 
+  //! Case-folded hash of each key, in the same order as keys.
+  std::vector<std::size_t> hashes;
+
+  /**
+   * Open-addressing hash index over the case-folded keys. Each slot
+   * holds an index into keys or -1 for an empty slot. The size is a
+   * power of two and at least twice the number of keys.
+   */
+  std::vector<std::int32_t> index;
+
+  int wellKnown[NUM_WELL_KNOWN_KEYS];
+
   static const Any emptyAny;
 };
 
+/**
+ * A borrowed view of Properties which optionally holds the properties
+ * lock for its life-time. Values obtained through it are references to
+ * the stored Any objects and must not outlive the handle.
+ */
 class PropertiesHandle
 {
 public:
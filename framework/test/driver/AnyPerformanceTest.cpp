@@ -0,0 +1,216 @@
+/*=============================================================================
+
+  Library: CppMicroServices
+
+  Copyright (c) The CppMicroServices developers. See the COPYRIGHT
+  file at the top-level directory of this distribution and at
+  https://github.com/CppMicroServices/CppMicroServices/COPYRIGHT .
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#include "cppmicroservices/Any.h"
+#include "cppmicroservices/BundleContext.h"
+#include "cppmicroservices/Framework.h"
+#include "cppmicroservices/FrameworkEvent.h"
+#include "cppmicroservices/FrameworkFactory.h"
+#include "cppmicroservices/ServiceReference.h"
+
+#include "TestUtils.h"
+#include "TestingMacros.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+using namespace cppmicroservices;
+
+namespace {
+
+// Counts all calls of the global operator new. This test is built into
+// an executable of its own, so the replacement operators below do not
+// affect other tests.
+std::atomic<std::size_t> allocationCount(0);
+
+struct IAnyPerfTestService
+{
+  virtual ~IAnyPerfTestService() {}
+};
+
+struct AnyPerfTestService : public IAnyPerfTestService
+{};
+
+// Too large to be stored inline by Any
+struct LargeValue
+{
+  char data[128];
+};
+
+std::ostream& operator<<(std::ostream& os, const LargeValue&)
+{
+  return os << "LargeValue";
+}
+
+template<class T>
+std::size_t CountCopyAllocations(const T& value)
+{
+  const Any any(value);
+  std::size_t before = allocationCount;
+  for (int i = 0; i < 100; ++i) {
+    Any copy(any);
+    Any moved(std::move(copy));
+    copy = moved;
+  }
+  return allocationCount - before;
+}
+
+void TestSmallValuesAreNotAllocated()
+{
+  US_TEST_CONDITION(CountCopyAllocations(42) == 0, "Copy int without alloc");
+  US_TEST_CONDITION(CountCopyAllocations(42L) == 0, "Copy long without alloc");
+  US_TEST_CONDITION(CountCopyAllocations(true) == 0,
+                    "Copy bool without alloc");
+  US_TEST_CONDITION(CountCopyAllocations(3.14) == 0,
+                    "Copy double without alloc");
+  US_TEST_CONDITION(CountCopyAllocations(std::string("short")) == 0,
+                    "Copy short string without alloc");
+
+  // Inline values keep their type and value
+  Any l(-7L);
+  Any copy(l);
+  US_TEST_CONDITION(copy.Type() == typeid(long), "Inline type");
+  US_TEST_CONDITION(any_cast<long>(copy) == -7, "Inline value");
+  ref_any_cast<long>(copy) = 8;
+  US_TEST_CONDITION(any_cast<long>(l) == -7 && any_cast<long>(copy) == 8,
+                    "Inline copies are independent");
+  Any moved(std::move(copy));
+  US_TEST_CONDITION(copy.Empty() && any_cast<long>(moved) == 8,
+                    "Inline values are moved");
+  US_TEST_CONDITION(Any(true).ToJSON() == "true", "Inline bool to JSON");
+  US_TEST_CONDITION(Any(1.5).ToString() == "1.5", "Inline double to string");
+
+  std::size_t large = CountCopyAllocations(LargeValue());
+  US_TEST_CONDITION(large > 0, "Copy large value with alloc");
+  US_TEST_OUTPUT(<< "Copying an Any with a large value 100 times allocated "
+                 << large << " times");
+}
+
+void TestServiceProperties(BundleContext context)
+{
+  const int nServices = 1000;
+  const int nLookups = 100;
+
+  std::vector<ServiceRegistration<IAnyPerfTestService>> regs;
+  auto service = std::make_shared<AnyPerfTestService>();
+
+  testing::HighPrecisionTimer timer;
+  timer.Start();
+  std::size_t before = allocationCount;
+  for (int i = 0; i < nServices; ++i) {
+    ServiceProperties props;
+    props["perf.int"] = i;
+    props["perf.long"] = static_cast<long>(i);
+    props["perf.bool"] = (i % 2 == 0);
+    props["perf.double"] = i * 0.5;
+    props["perf.string"] = std::string("value");
+    regs.push_back(
+      context.RegisterService<IAnyPerfTestService>(service, props));
+  }
+  std::size_t registerAllocs = allocationCount - before;
+  long long registerTime = timer.ElapsedMicro();
+
+  auto refs = context.GetServiceReferences<IAnyPerfTestService>();
+  US_TEST_CONDITION_REQUIRED(refs.size() == nServices,
+                             "All services registered");
+
+  timer.Start();
+  before = allocationCount;
+  long sum = 0;
+  for (int i = 0; i < nLookups; ++i) {
+    for (auto& ref : refs) {
+      sum += any_cast<int>(ref.GetProperty("perf.int"));
+      ref.GetProperty("perf.long");
+      ref.GetProperty("perf.bool");
+      ref.GetProperty("perf.double");
+      ref.GetProperty("perf.string");
+    }
+  }
+  std::size_t lookupAllocs = allocationCount - before;
+  long long lookupTime = timer.ElapsedMicro();
+  US_TEST_CONDITION(sum == static_cast<long>(nLookups) * nServices *
+                             (nServices - 1) / 2,
+                    "Property values");
+
+  timer.Start();
+  before = allocationCount;
+  for (int i = 0; i < nLookups; ++i) {
+    context.GetServiceReferences<IAnyPerfTestService>("(perf.long>=500)");
+  }
+  std::size_t filterAllocs = allocationCount - before;
+  long long filterTime = timer.ElapsedMicro();
+
+  for (auto& reg : regs) {
+    reg.Unregister();
+  }
+
+  US_TEST_OUTPUT(<< "Registering " << nServices << " services with 5 "
+                 << "properties: " << registerAllocs << " allocations, "
+                 << registerTime << " us");
+  US_TEST_OUTPUT(<< "Reading " << 5 * nLookups * nServices
+                 << " properties: " << lookupAllocs << " allocations, "
+                 << lookupTime << " us");
+  US_TEST_OUTPUT(<< nLookups << " filtered service lookups: " << filterAllocs
+                 << " allocations, " << filterTime << " us");
+}
+}
+
+void* operator new(std::size_t size)
+{
+  ++allocationCount;
+  if (void* p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+int AnyPerformanceTest(int /*argc*/, char* /*argv*/ [])
+{
+  US_TEST_BEGIN("AnyPerformanceTest");
+
+  TestSmallValuesAreNotAllocated();
+
+  FrameworkFactory factory;
+  auto framework = factory.NewFramework();
+  framework.Start();
+
+  TestServiceProperties(framework.GetBundleContext());
+
+  framework.Stop();
+  framework.WaitForStop(std::chrono::milliseconds::zero());
+
+  US_TEST_END()
+}
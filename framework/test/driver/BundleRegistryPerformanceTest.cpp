@@ -21,7 +21,9 @@ limitations under the License.
 =============================================================================*/
 
 #include "cppmicroservices/BundleContext.h"
+#include "cppmicroservices/Constants.h"
 #include "cppmicroservices/Framework.h"
+#include "cppmicroservices/FrameworkEvent.h"
 #include "cppmicroservices/FrameworkFactory.h"
 #include "cppmicroservices/GetBundleContext.h"
 #include "cppmicroservices/util/FileSystem.h"
@@ -30,6 +32,10 @@ limitations under the License.
 #include "TestingConfig.h"
 #include "TestingMacros.h"
 
+#include "miniz.h"
+
+#include <cstdio>
+#include <cstring>
 #include <mutex>
 #include <thread>
 #include <vector>
@@ -132,6 +138,244 @@ void TestConcurrent(const Framework& f)
 } // end anonymous namespace
 #endif
 
+namespace {
+
+// Write a zip file containing a bundle which only consists of a manifest.
+void WriteBundleZip(const std::string& path, const std::string& name)
+{
+  std::string manifest = "{ \"bundle.symbolic_name\" : \"" + name + "\" }";
+  std::string entry = name + "/manifest.json";
+  mz_zip_archive zip;
+  memset(&zip, 0, sizeof(mz_zip_archive));
+  mz_zip_writer_init_file(&zip, path.c_str(), 0);
+  mz_zip_writer_add_mem(&zip,
+                        entry.c_str(),
+                        manifest.c_str(),
+                        manifest.size(),
+                        MZ_DEFAULT_COMPRESSION);
+  mz_zip_writer_finalize_archive(&zip);
+  mz_zip_writer_end(&zip);
+}
+
+// Average time in nanoseconds to look up each installed bundle by id.
+long long LookupCost(const BundleContext& bc)
+{
+  std::vector<long> ids;
+  for (auto& b : bc.GetBundles()) {
+    ids.push_back(b.GetBundleId());
+  }
+
+  const int rounds = 20;
+  std::size_t found = 0;
+  testing::HighPrecisionTimer timer;
+  timer.Start();
+  for (int r = 0; r < rounds; ++r) {
+    for (auto id : ids) {
+      if (bc.GetBundle(id)) {
+        ++found;
+      }
+    }
+  }
+  long long ns = timer.ElapsedMicro() * 1000;
+  US_TEST_CONDITION(found == rounds * ids.size(), "Found all bundles by id");
+  return ns / static_cast<long long>(rounds * ids.size());
+}
+
+void TestLookupScaling(const Framework& f)
+{
+  auto bc = f.GetBundleContext();
+  long long smallCost = LookupCost(bc);
+  US_TEST_OUTPUT(<< "Bundle lookup by id with " << bc.GetBundles().size()
+                 << " bundles: " << smallCost << " ns");
+
+  const int numBundles = 5000;
+  testing::TempDir tempDir = testing::MakeUniqueTempDirectory();
+  std::vector<std::string> locations;
+  for (int i = 0; i < numBundles; ++i) {
+    std::string name = "perf_bundle_" + std::to_string(i);
+    locations.push_back(tempDir.Path + util::DIR_SEP + name + ".zip");
+    WriteBundleZip(locations.back(), name);
+  }
+
+  // Install the first half one location at a time and the second half
+  // as one batch.
+  const std::size_t half = locations.size() / 2;
+  std::vector<Bundle> installed;
+  testing::HighPrecisionTimer timer;
+  timer.Start();
+  for (std::size_t i = 0; i < half; ++i) {
+    auto bundles = bc.InstallBundles(locations[i]);
+    installed.insert(installed.end(), bundles.begin(), bundles.end());
+  }
+  US_TEST_OUTPUT(<< "Installing " << installed.size()
+                 << " bundles one at a time took " << timer.ElapsedMilli()
+                 << " ms");
+
+  timer.Start();
+  auto batch = bc.InstallBundles(std::vector<std::string>(
+    locations.begin() + half, locations.end()));
+  US_TEST_OUTPUT(<< "Installing " << batch.size()
+                 << " bundles as a batch took " << timer.ElapsedMilli()
+                 << " ms");
+  installed.insert(installed.end(), batch.begin(), batch.end());
+  US_TEST_CONDITION_REQUIRED(installed.size() == numBundles,
+                             "Installed all bundles");
+
+  bool ordered = true;
+  for (std::size_t i = half; i < installed.size(); ++i) {
+    ordered = ordered &&
+              installed[i].GetSymbolicName() ==
+                "perf_bundle_" + std::to_string(i) &&
+              installed[i].GetBundleId() > installed[i - 1].GetBundleId();
+  }
+  US_TEST_CONDITION(ordered, "Batch results and ids follow location order");
+
+  long long largeCost = LookupCost(bc);
+  US_TEST_OUTPUT(<< "Bundle lookup by id with " << bc.GetBundles().size()
+                 << " bundles: " << largeCost << " ns");
+
+  for (auto& b : installed) {
+    b.Uninstall();
+  }
+  US_TEST_CONDITION(!bc.GetBundle(installed.back().GetBundleId()),
+                    "Uninstalled bundles are not found by id");
+}
+void TestBatchInstallFailure(const Framework& f)
+{
+  auto bc = f.GetBundleContext();
+  const auto numInstalled = bc.GetBundles().size();
+
+  testing::TempDir tempDir = testing::MakeUniqueTempDirectory();
+  std::vector<std::string> locations;
+  for (const char* name : { "batch_a", "batch_b", "batch_c" }) {
+    locations.push_back(tempDir.Path + util::DIR_SEP + name + ".zip");
+    WriteBundleZip(locations.back(), name);
+  }
+  // Same symbolic name and version as batch_a
+  locations.push_back(tempDir.Path + util::DIR_SEP + "batch_a_copy.zip");
+  WriteBundleZip(locations.back(), "batch_a");
+
+  US_TEST_FOR_EXCEPTION(std::runtime_error, bc.InstallBundles(locations));
+  US_TEST_CONDITION(bc.GetBundles().size() == numInstalled,
+                    "Batch with a duplicate bundle installs nothing");
+
+  locations.back() = tempDir.Path + util::DIR_SEP + "does_not_exist.zip";
+  US_TEST_FOR_EXCEPTION(std::runtime_error, bc.InstallBundles(locations));
+  US_TEST_CONDITION(bc.GetBundles().size() == numInstalled,
+                    "Batch with an invalid location installs nothing");
+
+  locations.pop_back();
+  locations.push_back(locations.front());
+  auto bundles = bc.InstallBundles(locations);
+  US_TEST_CONDITION_REQUIRED(bundles.size() == 4, "Installed batch");
+  US_TEST_CONDITION(bundles.front() == bundles.back(),
+                    "Repeated location yields the same bundle");
+  for (std::size_t i = 0; i < 3; ++i) {
+    bundles[i].Uninstall();
+  }
+}
+
+void TestPersistentStorage()
+{
+  const int numBundles = 500;
+  testing::TempDir storageDir = testing::MakeUniqueTempDirectory();
+  testing::TempDir tempDir = testing::MakeUniqueTempDirectory();
+
+  FrameworkConfiguration config;
+  config[Constants::FRAMEWORK_STORAGE] = storageDir.Path;
+  config[Constants::FRAMEWORK_STORAGE_TYPE] =
+    Constants::FRAMEWORK_STORAGE_TYPE_FILE;
+
+  std::vector<std::string> locations;
+  for (int i = 0; i < numBundles; ++i) {
+    std::string name = "stored_bundle_" + std::to_string(i);
+    locations.push_back(tempDir.Path + util::DIR_SEP + name + ".zip");
+    WriteBundleZip(locations.back(), name);
+  }
+  // A location which does not fit into a storage record
+  std::string longDir = tempDir.Path + util::DIR_SEP + std::string(200, 'd');
+  util::MakePath(longDir);
+  locations.push_back(longDir + util::DIR_SEP + std::string(100, 'l') +
+                      ".zip");
+  WriteBundleZip(locations.back(), "stored_long_location");
+
+  std::vector<long> ids;
+  long uninstalledId = 0;
+  {
+    auto f = FrameworkFactory().NewFramework(config);
+    f.Start();
+    testing::HighPrecisionTimer timer;
+    timer.Start();
+    auto bundles = f.GetBundleContext().InstallBundles(locations);
+    US_TEST_OUTPUT(<< "Installing " << bundles.size()
+                   << " bundles into persistent storage took "
+                   << timer.ElapsedMilli() << " ms");
+    for (auto& b : bundles) {
+      ids.push_back(b.GetBundleId());
+    }
+    bundles[0].Start();
+    bundles[1].Start(Bundle::START_TRANSIENT);
+    uninstalledId = bundles[2].GetBundleId();
+    bundles[2].Uninstall();
+    f.Stop();
+    f.WaitForStop(std::chrono::milliseconds::zero());
+  }
+
+  // Restored bundles must not need their libraries
+  for (auto& location : locations) {
+    std::remove(location.c_str());
+  }
+
+  {
+    auto f = FrameworkFactory().NewFramework(config);
+    testing::HighPrecisionTimer timer;
+    timer.Start();
+    f.Start();
+    US_TEST_OUTPUT(<< "Starting a framework with " << numBundles
+                   << " stored bundles took " << timer.ElapsedMilli()
+                   << " ms");
+
+    auto bc = f.GetBundleContext();
+    bool restored = true;
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+      auto b = bc.GetBundle(ids[i]);
+      if (ids[i] == uninstalledId) {
+        restored = restored && !b;
+      } else {
+        restored = restored && b && b.GetLocation() == locations[i];
+      }
+    }
+    US_TEST_CONDITION(restored, "Bundles are restored with id and location");
+    US_TEST_CONDITION(bc.GetBundle(ids.back()).GetSymbolicName() ==
+                        "stored_long_location",
+                      "Bundle with a long location is restored");
+    US_TEST_CONDITION(bc.GetBundle(ids[0]).GetState() == Bundle::STATE_ACTIVE,
+                      "Started bundle is started on launch");
+    US_TEST_CONDITION(bc.GetBundle(ids[1]).GetState() != Bundle::STATE_ACTIVE,
+                      "Transiently started bundle is not started on launch");
+
+    testing::TempDir newDir = testing::MakeUniqueTempDirectory();
+    std::string location = newDir.Path + util::DIR_SEP + "stored_new.zip";
+    WriteBundleZip(location, "stored_new");
+    auto b = bc.InstallBundles(location).front();
+    US_TEST_CONDITION(b.GetBundleId() > ids.back(),
+                      "Bundle ids are not reused after a restart");
+
+    f.Stop();
+    f.WaitForStop(std::chrono::milliseconds::zero());
+  }
+
+  config[Constants::FRAMEWORK_STORAGE_CLEAN] =
+    Constants::FRAMEWORK_STORAGE_CLEAN_ONFIRSTINIT;
+  auto f = FrameworkFactory().NewFramework(config);
+  f.Start();
+  US_TEST_CONDITION(!f.GetBundleContext().GetBundle(ids[0]),
+                    "Cleaning the storage removes stored bundles");
+  f.Stop();
+  f.WaitForStop(std::chrono::milliseconds::zero());
+}
+}
+
 int BundleRegistryPerformanceTest(int /*argc*/, char* /*argv*/ [])
 {
   US_TEST_BEGIN("BundleRegistryPerformanceTest")
@@ -153,7 +397,13 @@ int BundleRegistryPerformanceTest(int /*argc*/, char* /*argv*/ [])
   TestConcurrent(framework);
 #  endif
 #endif
+  US_TEST_OUTPUT(<< "Testing bundle lookup scaling");
+  TestLookupScaling(framework);
+  TestBatchInstallFailure(framework);
+
   framework.Stop();
 
+  TestPersistentStorage();
+
   US_TEST_END()
 }
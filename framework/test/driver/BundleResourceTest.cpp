@@ -24,17 +24,26 @@
 #include "cppmicroservices/Bundle.h"
 #include "cppmicroservices/BundleContext.h"
 #include "cppmicroservices/BundleResourceStream.h"
+#include "cppmicroservices/Constants.h"
 #include "cppmicroservices/Framework.h"
+#include "cppmicroservices/FrameworkEvent.h"
 #include "cppmicroservices/FrameworkFactory.h"
 #include "cppmicroservices/GetBundleContext.h"
+#include "cppmicroservices/util/FileSystem.h"
 
 #include "TestUtils.h"
 #include "TestingConfig.h"
 #include "TestingMacros.h"
 
+#include "miniz.h"
+
 #include <cassert>
+#include <cstring>
+#include <iterator>
 #include <memory>
+#include <thread>
 #include <unordered_set>
+#include <vector>
 
 using namespace cppmicroservices;
 
@@ -315,6 +324,311 @@ void testCompressedResource(const Bundle& bundle)
   US_TEST_CONDITION(bmp.eof(), "EOF check");
 }
 
+void testResourceView(const Bundle& bundle)
+{
+  US_TEST_CONDITION(BundleResource().GetView().empty(),
+                    "Empty view of invalid resource")
+
+  for (auto path : { "/icons/cppmicroservices.png", "/icons/compressable.bmp" }) {
+    BundleResource res = bundle.GetResource(path);
+    BundleResourceView view = res.GetView();
+    US_TEST_CONDITION_REQUIRED(view.size() ==
+                                 static_cast<std::size_t>(res.GetSize()),
+                               "Check view size")
+
+    BundleResourceStream rs(res, std::ios_base::binary);
+    std::string content{ std::istreambuf_iterator<char>(rs),
+                         std::istreambuf_iterator<char>() };
+    US_TEST_CONDITION(std::equal(view.begin(), view.end(), content.begin()),
+                      "Equal view and stream contents")
+  }
+}
+
+struct ZipEntry
+{
+  std::string name;
+  std::string content;
+  int level;
+};
+
+std::vector<Bundle> InstallResourceZip(BundleContext context,
+                                       const std::string& path,
+                                       const std::string& name,
+                                       const std::vector<ZipEntry>& entries)
+{
+  std::string manifest = "{ \"bundle.symbolic_name\" : \"" + name + "\" }";
+  mz_zip_archive zip;
+  memset(&zip, 0, sizeof(mz_zip_archive));
+  mz_zip_writer_init_file(&zip, path.c_str(), 0);
+  mz_zip_writer_add_mem(&zip,
+                        (name + "/manifest.json").c_str(),
+                        manifest.c_str(),
+                        manifest.size(),
+                        MZ_DEFAULT_COMPRESSION);
+  for (auto& entry : entries) {
+    mz_zip_writer_add_mem(&zip,
+                          (name + "/" + entry.name).c_str(),
+                          entry.content.c_str(),
+                          entry.content.size(),
+                          entry.level);
+  }
+  mz_zip_writer_finalize_archive(&zip);
+  mz_zip_writer_end(&zip);
+  return context.InstallBundles(path);
+}
+
+void testStoredResourceView(BundleContext context)
+{
+  testing::TempDir dir = testing::MakeUniqueTempDirectory();
+  std::string stored(64 * 1024, 'x');
+  std::string compressed(64 * 1024, 'y');
+
+  auto bundles = InstallResourceZip(
+    context,
+    dir.Path + util::DIR_SEP + "stored_view.zip",
+    "stored_view",
+    { { "stored.dat", stored, MZ_NO_COMPRESSION },
+      { "compressed.dat", compressed, MZ_DEFAULT_COMPRESSION } });
+  US_TEST_CONDITION_REQUIRED(bundles.size() == 1, "Install stored_view")
+
+  BundleResource storedRes = bundles.front().GetResource("stored.dat");
+  BundleResourceView view1 = storedRes.GetView();
+  BundleResourceView view2 = storedRes.GetView();
+  US_TEST_CONDITION_REQUIRED(view1.size() == stored.size(),
+                             "Check stored view size")
+  US_TEST_CONDITION(std::equal(view1.begin(), view1.end(), stored.begin()),
+                    "Check stored view contents")
+#if defined(US_PLATFORM_APPLE) || defined(US_PLATFORM_POSIX)
+  US_TEST_CONDITION(view1.data() == view2.data(),
+                    "Stored resource is viewed in place")
+#endif
+
+  BundleResource compressedRes = bundles.front().GetResource("compressed.dat");
+  view1 = compressedRes.GetView();
+  view2 = compressedRes.GetView();
+  US_TEST_CONDITION_REQUIRED(view1.size() == compressed.size(),
+                             "Check compressed view size")
+  US_TEST_CONDITION(
+    std::equal(view1.begin(), view1.end(), compressed.begin()),
+    "Check compressed view contents")
+  US_TEST_CONDITION(view1.data() == view2.data(),
+                    "Compressed resource is served from the cache")
+
+  // Views keep their data alive after the bundle is gone.
+  view1 = storedRes.GetView();
+  storedRes = BundleResource();
+  bundles.front().Uninstall();
+  US_TEST_CONDITION(
+    std::equal(view1.begin(), view1.end(), stored.begin()),
+    "View outlives its bundle")
+}
+
+void testInflatedResourceStream(BundleContext context)
+{
+  testing::TempDir dir = testing::MakeUniqueTempDirectory();
+  std::string content;
+  for (int i = 0; content.size() < 200 * 1024; ++i) {
+    content += "line " + std::to_string(i * 7919 % 100003) + "\n";
+  }
+
+  auto bundles =
+    InstallResourceZip(context,
+                       dir.Path + util::DIR_SEP + "inflated_stream.zip",
+                       "inflated_stream",
+                       { { "data.txt", content, MZ_DEFAULT_COMPRESSION } });
+  US_TEST_CONDITION_REQUIRED(bundles.size() == 1, "Install inflated_stream")
+  BundleResource res = bundles.front().GetResource("data.txt");
+  US_TEST_CONDITION_REQUIRED(res.GetCompressedSize() < res.GetSize(),
+                             "Resource is compressed")
+
+  BundleResourceStream rs(res, std::ios_base::binary);
+  std::string read{ std::istreambuf_iterator<char>(rs),
+                    std::istreambuf_iterator<char>() };
+  US_TEST_CONDITION(read == content, "Read inflated binary contents")
+
+  rs.clear();
+  rs.seekg(0, std::ios_base::end);
+  US_TEST_CONDITION(rs.tellg() == static_cast<std::streampos>(content.size()),
+                    "Seek to end of inflated stream")
+  rs.seekg(150000);
+  US_TEST_CONDITION(rs.get() == content[150000], "Seek forward")
+  rs.seekg(10);
+  US_TEST_CONDITION(rs.get() == content[10], "Seek backward")
+  US_TEST_CONDITION(rs.tellg() == 11, "Position after seek")
+
+  // Put back characters across a window boundary
+  rs.seekg(32768);
+  rs.get();
+  rs.unget();
+  rs.unget();
+  US_TEST_CONDITION(rs.good() && rs.tellg() == 32767, "Unget position")
+  US_TEST_CONDITION(rs.get() == content[32767], "Unget character")
+
+  BundleResourceStream text(res);
+  std::string line;
+  std::size_t lines = 0;
+  std::size_t expectedLines = 0;
+  while (std::getline(text, line)) {
+    ++lines;
+  }
+  for (char c : content) {
+    expectedLines += c == '\n' ? 1 : 0;
+  }
+  US_TEST_CONDITION(lines == expectedLines, "Read inflated text lines")
+
+  text.clear();
+  text.seekg(0, std::ios_base::end);
+  US_TEST_CONDITION(text.tellg() ==
+                      static_cast<std::streampos>(content.size() - 1),
+                    "Text mode drops the last newline")
+}
+
+void testResourcePathIndex(BundleContext context)
+{
+  testing::TempDir dir = testing::MakeUniqueTempDirectory();
+  std::vector<ZipEntry> entries;
+  for (auto name : { "", "dir/", "dir/b.txt", "dir/a.txt", "dir/sub/",
+                     "dir/sub/c.txt", "dir2/", "dir2/d.txt", "dirx.txt" }) {
+    std::string path = name;
+    entries.push_back(
+      { path, path.empty() || path.back() == '/' ? std::string() : path, 6 });
+  }
+  auto bundles =
+    InstallResourceZip(context,
+                       dir.Path + util::DIR_SEP + "path_index.zip",
+                       "path_index",
+                       entries);
+  US_TEST_CONDITION_REQUIRED(bundles.size() == 1, "Install path_index")
+  auto bundle = bundles.front();
+
+  std::vector<std::string> expected = { "a.txt", "b.txt", "sub/" };
+  US_TEST_CONDITION(bundle.GetResource("dir/").GetChildren() == expected,
+                    "Direct children in sorted order")
+  US_TEST_CONDITION(bundle.GetResource("dirx.txt").GetChildren().empty(),
+                    "Files have no children")
+  US_TEST_CONDITION(bundle.FindResources("dir", "*.txt", true).size() == 3,
+                    "Find resources recursively")
+  US_TEST_CONDITION(bundle.FindResources("dir", "*.txt", false).size() == 2,
+                    "Find resources non-recursively")
+  US_TEST_CONDITION(bundle.FindResources("", "*.txt", true).size() == 5,
+                    "Find resources from the root")
+  US_TEST_CONDITION(bundle.GetResource("DIR/SUB/C.TXT").IsValid(),
+                    "Case-insensitive lookup")
+  US_TEST_CONDITION(!bundle.GetResource("dir/sub/e.txt").IsValid(),
+                    "Missing resource")
+}
+
+long GetCacheCounter(BundleContext context, const std::string& key)
+{
+  return any_cast<long>(context.GetProperty(key));
+}
+
+void testResourceCache()
+{
+  testing::TempDir dir = testing::MakeUniqueTempDirectory();
+  std::vector<ZipEntry> entries;
+  for (auto name : { "a.dat", "b.dat" }) {
+    entries.push_back({ name, std::string(64 * 1024, name[0]), 6 });
+  }
+
+  for (int cacheSize : { 100 * 1024, 0 }) {
+    FrameworkConfiguration config;
+    config[Constants::FRAMEWORK_RESOURCE_CACHE_SIZE] = cacheSize;
+    auto framework = FrameworkFactory().NewFramework(config);
+    framework.Start();
+    auto context = framework.GetBundleContext();
+
+    auto bundles = InstallResourceZip(
+      context, dir.Path + util::DIR_SEP + "cached.zip", "cached", entries);
+    US_TEST_CONDITION_REQUIRED(bundles.size() == 1, "Install cached")
+    BundleResource a = bundles.front().GetResource("a.dat");
+    BundleResource b = bundles.front().GetResource("b.dat");
+
+    // The manifest was read through the cache during installation
+    const long hits0 =
+      GetCacheCounter(context, Constants::FRAMEWORK_RESOURCE_CACHE_HITS);
+    const long misses0 =
+      GetCacheCounter(context, Constants::FRAMEWORK_RESOURCE_CACHE_MISSES);
+    const long evictions0 =
+      GetCacheCounter(context, Constants::FRAMEWORK_RESOURCE_CACHE_EVICTIONS);
+
+    BundleResourceView a1 = a.GetView();
+    BundleResourceView a2 = a.GetView();
+    US_TEST_CONDITION(
+      std::equal(a2.begin(), a2.end(), entries[0].content.begin()),
+      "Check cached contents")
+    // Only one entry fits, so reading b evicts a.
+    BundleResourceView b1 = b.GetView();
+    BundleResourceView a3 = a.GetView();
+
+    const long hits =
+      GetCacheCounter(context, Constants::FRAMEWORK_RESOURCE_CACHE_HITS) -
+      hits0;
+    const long misses =
+      GetCacheCounter(context, Constants::FRAMEWORK_RESOURCE_CACHE_MISSES) -
+      misses0;
+    const long evictions =
+      GetCacheCounter(context, Constants::FRAMEWORK_RESOURCE_CACHE_EVICTIONS) -
+      evictions0;
+    if (cacheSize > 0) {
+      US_TEST_CONDITION(a1.data() == a2.data(), "Cache hit shares the data")
+      US_TEST_CONDITION(a1.data() != a3.data(), "Evicted data is reloaded")
+      US_TEST_CONDITION(hits == 1 && misses == 3 && evictions >= 2,
+                        "Cache counters")
+    } else {
+      US_TEST_CONDITION(a1.data() != a2.data(), "Disabled cache")
+      US_TEST_CONDITION(hits == 0 && misses == 0 && evictions == 0,
+                        "Disabled cache counters")
+    }
+    // Views stay valid after eviction
+    US_TEST_CONDITION(
+      std::equal(a1.begin(), a1.end(), entries[0].content.begin()),
+      "Evicted view contents")
+
+    framework.Stop();
+    framework.WaitForStop(std::chrono::milliseconds::zero());
+  }
+}
+
+void testConcurrentResourceReads(const Bundle& bundle)
+{
+  const int nThreads = 8;
+  const int nReads = 20;
+
+  BundleResource res = bundle.GetResource("/icons/compressable.bmp");
+  BundleResourceView expected = res.GetView();
+  US_TEST_CONDITION_REQUIRED(expected.size() == 300122, "Check view size")
+
+  std::vector<int> matches(nThreads, 0);
+  std::vector<std::thread> threads;
+  testing::HighPrecisionTimer timer;
+  timer.Start();
+  for (int t = 0; t < nThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < nReads; ++i) {
+        BundleResourceView view = res.GetView();
+        if (view.size() == expected.size() &&
+            std::equal(view.begin(), view.end(), expected.begin())) {
+          ++matches[t];
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  long long elapsed = timer.ElapsedMicro();
+
+  bool allMatch = true;
+  for (int count : matches) {
+    allMatch = allMatch && count == nReads;
+  }
+  US_TEST_CONDITION(allMatch, "Concurrently decompressed contents")
+  US_TEST_OUTPUT(<< nThreads << " threads decompressed "
+                 << nThreads * nReads << " resources in " << elapsed
+                 << " us");
+}
+
 struct ResourceComparator
 {
   bool operator()(const BundleResource& mr1, const BundleResource& mr2) const
@@ -507,6 +821,13 @@ int BundleResourceTest(int /*argc*/, char* /*argv*/ [])
 
   testCompressedResource(bundleR);
 
+  testResourceView(bundleR);
+  testStoredResourceView(framework.GetBundleContext());
+  testConcurrentResourceReads(bundleR);
+  testInflatedResourceStream(framework.GetBundleContext());
+  testResourcePathIndex(framework.GetBundleContext());
+  testResourceCache();
+
   BundleResource foo = bundleR.GetResource("foo.txt");
   US_TEST_CONDITION(foo.IsValid() == true, "Valid resource")
 
@@ -0,0 +1,449 @@
+/*=============================================================================
+
+  Library: CppMicroServices
+
+  Copyright (c) The CppMicroServices developers. See the COPYRIGHT
+  file at the top-level directory of this distribution and at
+  https://github.com/CppMicroServices/CppMicroServices/COPYRIGHT .
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#include "cppmicroservices/BundleContext.h"
+#include "cppmicroservices/BundleEvent.h"
+#include "cppmicroservices/Constants.h"
+#include "cppmicroservices/Framework.h"
+#include "cppmicroservices/FrameworkEvent.h"
+#include "cppmicroservices/FrameworkFactory.h"
+#include "cppmicroservices/util/FileSystem.h"
+
+#include "TestUtils.h"
+#include "TestingMacros.h"
+
+#include "miniz.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace cppmicroservices;
+
+namespace {
+
+// Write a zip file containing a bundle which only consists of a manifest.
+// Bundles with an activator fail to start, since there is no library.
+std::string WriteBundleZip(const testing::TempDir& dir,
+                           const std::string& name,
+                           const std::vector<std::string>& required,
+                           bool activator = false,
+                           bool lazy = false)
+{
+  std::string manifest = "{ \"bundle.symbolic_name\" : \"" + name + "\"";
+  if (!required.empty()) {
+    manifest += ", \"bundle.requires\" : [";
+    for (std::size_t i = 0; i < required.size(); ++i) {
+      manifest += (i ? ", \"" : "\"") + required[i] + "\"";
+    }
+    manifest += "]";
+  }
+  if (activator) {
+    manifest += ", \"bundle.activator\" : true";
+  }
+  if (lazy) {
+    manifest += ", \"bundle.activation_policy\" : \"lazy\"";
+  }
+  manifest += " }";
+
+  std::string path = dir.Path + util::DIR_SEP + name + ".zip";
+  std::string entry = name + "/manifest.json";
+  mz_zip_archive zip;
+  memset(&zip, 0, sizeof(mz_zip_archive));
+  mz_zip_writer_init_file(&zip, path.c_str(), 0);
+  mz_zip_writer_add_mem(&zip,
+                        entry.c_str(),
+                        manifest.c_str(),
+                        manifest.size(),
+                        MZ_DEFAULT_COMPRESSION);
+  mz_zip_writer_finalize_archive(&zip);
+  mz_zip_writer_end(&zip);
+  return path;
+}
+
+// Records the order of BUNDLE_STARTED events and simulates slow
+// activators by sleeping while bundles with a "slow" name are starting.
+struct StartRecorder
+{
+  std::mutex mutex;
+  std::vector<std::string> started;
+  std::chrono::milliseconds delay{ 20 };
+
+  void operator()(const BundleEvent& event)
+  {
+    auto name = event.GetBundle().GetSymbolicName();
+    if (event.GetType() == BundleEvent::BUNDLE_STARTING &&
+        name.compare(0, 4, "slow") == 0) {
+      std::this_thread::sleep_for(delay);
+    } else if (event.GetType() == BundleEvent::BUNDLE_STARTED) {
+      std::lock_guard<std::mutex> l(mutex);
+      started.push_back(name);
+    }
+  }
+
+  std::size_t Position(const std::string& name)
+  {
+    std::lock_guard<std::mutex> l(mutex);
+    return std::find(started.begin(), started.end(), name) - started.begin();
+  }
+};
+
+void Uninstall(const std::vector<Bundle>& bundles)
+{
+  for (auto b : bundles) {
+    b.Uninstall();
+  }
+}
+
+void TestDependencyOrder(Framework& f, StartRecorder& recorder)
+{
+  testing::TempDir dir = testing::MakeUniqueTempDirectory();
+  // slow_c requires slow_b requires slow_a, fast_d is independent
+  auto bundles = f.GetBundleContext().InstallBundles(
+    { WriteBundleZip(dir, "slow_c", { "slow_b" }),
+      WriteBundleZip(dir, "fast_d", {}),
+      WriteBundleZip(dir, "slow_b", { "slow_a" }),
+      WriteBundleZip(dir, "slow_a", {}) });
+
+  auto timings = f.StartBundles(bundles);
+  US_TEST_CONDITION_REQUIRED(timings.size() == 4, "Timing for each bundle");
+
+  bool allActive = true;
+  for (auto& timing : timings) {
+    allActive = allActive && !timing.error &&
+                timing.bundle.GetState() == Bundle::STATE_ACTIVE;
+    US_TEST_OUTPUT(<< timing.bundle.GetSymbolicName() << ": "
+                   << timing.begin.count() << " us - " << timing.end.count()
+                   << " us" << (timing.critical ? " (critical)" : ""));
+  }
+  US_TEST_CONDITION(allActive, "All bundles started");
+
+  US_TEST_CONDITION(recorder.Position("slow_a") < recorder.Position("slow_b") &&
+                      recorder.Position("slow_b") <
+                        recorder.Position("slow_c"),
+                    "Dependencies are started first");
+  US_TEST_CONDITION(timings[0].dependencies.size() == 1 &&
+                      timings[0].dependencies[0] == bundles[2],
+                    "Dependencies are reported");
+  US_TEST_CONDITION(timings[0].begin >= timings[2].end &&
+                      timings[2].begin >= timings[3].end,
+                    "Dependent bundles begin after their dependencies end");
+  US_TEST_CONDITION(timings[0].critical && timings[2].critical &&
+                      timings[3].critical && !timings[1].critical,
+                    "Critical path");
+
+  Uninstall(bundles);
+}
+
+void TestFailedDependency(Framework& f)
+{
+  testing::TempDir dir = testing::MakeUniqueTempDirectory();
+  auto bundles = f.GetBundleContext().InstallBundles(
+    { WriteBundleZip(dir, "broken", {}, true),
+      WriteBundleZip(dir, "needs_broken", { "broken" }),
+      WriteBundleZip(dir, "independent", {}) });
+
+  // Failures are published on the threads starting the bundles
+  std::mutex mutex;
+  std::size_t errors = 0;
+  std::map<std::string, std::string> messages;
+  auto token = f.GetBundleContext().AddFrameworkListener(
+    [&mutex, &errors, &messages](const FrameworkEvent& event) {
+      if (event.GetType() == FrameworkEvent::FRAMEWORK_ERROR) {
+        std::lock_guard<std::mutex> l(mutex);
+        ++errors;
+        messages[event.GetBundle().GetSymbolicName()] = event.GetMessage();
+      }
+    });
+
+  auto timings = f.StartBundles(bundles);
+  f.GetBundleContext().RemoveListener(std::move(token));
+
+  US_TEST_CONDITION(timings[0].error && timings[1].error && !timings[2].error,
+                    "Failures are recorded");
+  US_TEST_CONDITION(bundles[1].GetState() != Bundle::STATE_ACTIVE,
+                    "Bundle depending on a failed bundle is not started");
+  US_TEST_CONDITION(bundles[2].GetState() == Bundle::STATE_ACTIVE,
+                    "Independent bundle is started");
+  US_TEST_CONDITION(errors == 2, "Failures are published as framework events");
+  US_TEST_CONDITION(
+    messages["broken"] == "Failed to start bundle during StartBundles",
+    "Framework event of a failed bundle");
+  US_TEST_CONDITION(messages["needs_broken"] ==
+                      "Bundle not started during StartBundles, a dependency "
+                      "failed to start",
+                    "Framework event of a bundle with a failed dependency");
+
+  Uninstall(bundles);
+}
+
+void TestCycle(Framework& f, StartRecorder& recorder)
+{
+  testing::TempDir dir = testing::MakeUniqueTempDirectory();
+  auto bundles = f.GetBundleContext().InstallBundles(
+    { WriteBundleZip(dir, "cycle_x", { "cycle_y" }),
+      WriteBundleZip(dir, "cycle_y", { "cycle_x" }) });
+
+  auto timings = f.StartBundles(bundles);
+  US_TEST_CONDITION(!timings[0].error && !timings[1].error,
+                    "Bundles in a cycle are started");
+  US_TEST_CONDITION(recorder.Position("cycle_x") < recorder.Position("cycle_y"),
+                    "Cycles are broken in batch order");
+
+  Uninstall(bundles);
+
+  // cycle_c depends on cycle_d, which depends on the cycle of cycle_a
+  // and cycle_b. Only the dependency within the cycle is dropped.
+  bundles = f.GetBundleContext().InstallBundles(
+    { WriteBundleZip(dir, "cycle_a", { "cycle_b" }),
+      WriteBundleZip(dir, "cycle_b", { "cycle_a" }),
+      WriteBundleZip(dir, "cycle_c", { "cycle_d" }),
+      WriteBundleZip(dir, "cycle_d", { "cycle_a" }) });
+
+  timings = f.StartBundles(bundles);
+  US_TEST_CONDITION(timings[2].dependencies.size() == 1 &&
+                      timings[2].dependencies[0] == bundles[3],
+                    "Dependencies downstream of a cycle are kept");
+  US_TEST_CONDITION(timings[0].dependencies.empty() &&
+                      timings[1].dependencies.size() == 1,
+                    "The dependency on a later bundle in a cycle is dropped");
+  US_TEST_CONDITION(recorder.Position("cycle_a") <
+                        recorder.Position("cycle_b") &&
+                      recorder.Position("cycle_b") <
+                        recorder.Position("cycle_d") &&
+                      recorder.Position("cycle_d") <
+                        recorder.Position("cycle_c"),
+                    "Bundles downstream of a cycle start in dependency order");
+
+  Uninstall(bundles);
+}
+
+void TestStartupTime(Framework& f)
+{
+  const int numBundles = 32;
+  testing::TempDir dir = testing::MakeUniqueTempDirectory();
+  std::vector<std::string> serialLocations;
+  std::vector<std::string> batchLocations;
+  for (int i = 0; i < numBundles; ++i) {
+    serialLocations.push_back(
+      WriteBundleZip(dir, "slow_serial_" + std::to_string(i), {}));
+    batchLocations.push_back(
+      WriteBundleZip(dir, "slow_batch_" + std::to_string(i), {}));
+  }
+  auto serial = f.GetBundleContext().InstallBundles(serialLocations);
+  auto batch = f.GetBundleContext().InstallBundles(batchLocations);
+
+  testing::HighPrecisionTimer timer;
+  timer.Start();
+  for (auto b : serial) {
+    b.Start();
+  }
+  long long serialTime = timer.ElapsedMilli();
+
+  timer.Start();
+  auto timings = f.StartBundles(batch);
+  long long batchTime = timer.ElapsedMilli();
+
+  US_TEST_OUTPUT(<< "Starting " << numBundles << " independent bundles "
+                 << "one at a time took " << serialTime << " ms, "
+                 << "as a batch " << batchTime << " ms");
+  US_TEST_CONDITION(std::all_of(timings.begin(),
+                                timings.end(),
+                                [](const BundleStartTiming& t) {
+                                  return !t.error;
+                                }),
+                    "All bundles of the batch started");
+#ifdef US_ENABLE_THREADING_SUPPORT
+  // The batch uses one thread per hardware thread
+  if (std::thread::hardware_concurrency() > 1) {
+    US_TEST_CONDITION(batchTime < serialTime,
+                      "Independent bundles are started concurrently");
+  }
+#endif
+
+  Uninstall(serial);
+  Uninstall(batch);
+}
+
+struct ILazyTestService
+{
+  virtual ~ILazyTestService() {}
+};
+
+struct LazyTestService : public ILazyTestService
+{};
+
+void TestLazyActivation(Framework& f)
+{
+  testing::TempDir dir = testing::MakeUniqueTempDirectory();
+  auto bundles = f.GetBundleContext().InstallBundles(
+    { WriteBundleZip(dir, "lazy", {}, false, true),
+      WriteBundleZip(dir, "lazy_broken", {}, true, true) });
+  auto lazy = bundles[0];
+  auto broken = bundles[1];
+
+  std::vector<BundleEvent::Type> events;
+  auto bundleToken = f.GetBundleContext().AddBundleListener(
+    [&events, &lazy](const BundleEvent& event) {
+      if (event.GetBundle() == lazy) {
+        events.push_back(event.GetType());
+      }
+    });
+  std::size_t errors = 0;
+  auto frameworkToken = f.GetBundleContext().AddFrameworkListener(
+    [&errors](const FrameworkEvent& event) {
+      if (event.GetType() == FrameworkEvent::FRAMEWORK_ERROR) {
+        ++errors;
+      }
+    });
+
+  lazy.Start();
+  US_TEST_CONDITION(lazy.GetState() == Bundle::STATE_ACTIVE,
+                    "Start() without options activates eagerly");
+  lazy.Stop();
+  events.clear();
+
+  lazy.Start(Bundle::START_ACTIVATION_POLICY);
+  US_TEST_CONDITION(lazy.GetState() == Bundle::STATE_STARTING,
+                    "Lazy bundle waits in the STARTING state");
+  US_TEST_CONDITION(events.size() == 1 &&
+                      events[0] == BundleEvent::BUNDLE_LAZY_ACTIVATION,
+                    "BUNDLE_LAZY_ACTIVATION event");
+
+  // Services may be registered on behalf of a lazy bundle before it is
+  // activated, e.g. by declarative services.
+  lazy.GetBundleContext().RegisterService<ILazyTestService>(
+    std::make_shared<LazyTestService>());
+  auto ref = f.GetBundleContext().GetServiceReference<ILazyTestService>();
+  US_TEST_CONDITION(lazy.GetState() == Bundle::STATE_STARTING,
+                    "Getting a service reference does not activate");
+  US_TEST_CONDITION(f.GetBundleContext().GetService(ref) != nullptr,
+                    "Get service of lazy bundle");
+  US_TEST_CONDITION(lazy.GetState() == Bundle::STATE_ACTIVE,
+                    "Getting a service activates the bundle");
+  US_TEST_CONDITION(events.size() == 3 &&
+                      events[1] == BundleEvent::BUNDLE_STARTING &&
+                      events[2] == BundleEvent::BUNDLE_STARTED,
+                    "BUNDLE_STARTING and BUNDLE_STARTED on activation");
+
+  broken.Start(Bundle::START_ACTIVATION_POLICY);
+  US_TEST_CONDITION(broken.GetState() == Bundle::STATE_STARTING && errors == 0,
+                    "Library of a lazy bundle is not loaded when started");
+  broken.GetBundleContext().RegisterService<ILazyTestService>(
+    std::make_shared<LazyTestService>());
+  for (auto& r :
+       f.GetBundleContext().GetServiceReferences<ILazyTestService>()) {
+    if (r.GetBundle() == broken) {
+      ref = r;
+    }
+  }
+  US_TEST_CONDITION(!f.GetBundleContext().GetService(ref),
+                    "No service from a bundle whose activation failed");
+  US_TEST_CONDITION(broken.GetState() == Bundle::STATE_RESOLVED && errors == 1,
+                    "Failed lazy activation is published as framework event");
+
+  f.GetBundleContext().RemoveListener(std::move(bundleToken));
+  f.GetBundleContext().RemoveListener(std::move(frameworkToken));
+  Uninstall(bundles);
+}
+
+// Counts the threads which delivered a BUNDLE_STARTING event
+std::atomic<int> bundleThreadCount(0);
+
+void CountBundleThreads(const BundleEvent& event)
+{
+  thread_local bool counted = false;
+  if (event.GetType() == BundleEvent::BUNDLE_STARTING && !counted) {
+    counted = true;
+    ++bundleThreadCount;
+  }
+}
+
+void TestBundleThreadReuse()
+{
+  FrameworkConfiguration config;
+  config[Constants::FRAMEWORK_BUNDLE_THREADS] = 1;
+  auto f = FrameworkFactory().NewFramework(config);
+  f.Start();
+
+  testing::TempDir dir = testing::MakeUniqueTempDirectory();
+  auto bundle = f.GetBundleContext()
+                  .InstallBundles(WriteBundleZip(dir, "reused", {}))
+                  .front();
+  f.GetBundleContext().AddBundleListener(CountBundleThreads);
+
+  const int cycles = 1000;
+  testing::HighPrecisionTimer timer;
+  timer.Start();
+  for (int i = 0; i < cycles; ++i) {
+    bundle.Start();
+    bundle.Stop();
+  }
+  US_TEST_OUTPUT(<< cycles << " start/stop cycles took "
+                 << timer.ElapsedMilli() << " ms");
+
+  // Wait longer than the keep-alive time of idle bundle threads
+  std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+  bundle.Start();
+
+  US_TEST_CONDITION(bundleThreadCount == 1,
+                    "Idle bundle threads are reused after their keep-alive "
+                    "time");
+
+  f.Stop();
+  f.WaitForStop(std::chrono::milliseconds::zero());
+}
+}
+
+int BundleStartPerformanceTest(int /*argc*/, char* /*argv*/ [])
+{
+  US_TEST_BEGIN("BundleStartPerformanceTest");
+
+  FrameworkFactory factory;
+  auto framework = factory.NewFramework();
+  framework.Start();
+
+  StartRecorder recorder;
+  framework.GetBundleContext().AddBundleListener(std::ref(recorder));
+
+  TestDependencyOrder(framework, recorder);
+  TestFailedDependency(framework);
+  TestCycle(framework, recorder);
+  TestStartupTime(framework);
+  TestLazyActivation(framework);
+
+  framework.Stop();
+  framework.WaitForStop(std::chrono::milliseconds::zero());
+
+#ifdef US_ENABLE_THREADING_SUPPORT
+  TestBundleThreadReuse();
+#endif
+
+  US_TEST_END()
+}
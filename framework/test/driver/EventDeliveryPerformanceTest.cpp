@@ -0,0 +1,316 @@
+/*=============================================================================
+
+  Library: CppMicroServices
+
+  Copyright (c) The CppMicroServices developers. See the COPYRIGHT
+  file at the top-level directory of this distribution and at
+  https://github.com/CppMicroServices/CppMicroServices/COPYRIGHT .
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#include "cppmicroservices/BundleContext.h"
+#include "cppmicroservices/BundleEvent.h"
+#include "cppmicroservices/Constants.h"
+#include "cppmicroservices/Framework.h"
+#include "cppmicroservices/FrameworkEvent.h"
+#include "cppmicroservices/FrameworkFactory.h"
+#include "cppmicroservices/ServiceEvent.h"
+
+#include "TestUtils.h"
+#include "TestingMacros.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace cppmicroservices;
+
+namespace {
+
+struct IEventPerfTestService
+{
+  virtual ~IEventPerfTestService() {}
+};
+
+struct EventPerfTestService : public IEventPerfTestService
+{};
+
+// A service listener which takes its time to process an event and
+// records the service ids in the order of the REGISTERED events.
+struct SlowListener
+{
+  std::chrono::milliseconds delay{ 5 };
+  std::mutex mutex;
+  std::vector<long> ids;
+
+  void operator()(const ServiceEvent& event)
+  {
+    std::this_thread::sleep_for(delay);
+    if (event.GetType() == ServiceEvent::SERVICE_REGISTERED) {
+      std::lock_guard<std::mutex> l(mutex);
+      ids.push_back(
+        any_cast<long>(event.GetServiceReference().GetProperty(
+          Constants::SERVICE_ID)));
+    }
+  }
+
+  std::size_t Count()
+  {
+    std::lock_guard<std::mutex> l(mutex);
+    return ids.size();
+  }
+};
+
+Framework NewFramework(const std::string& delivery, int queueLimit = 1024)
+{
+  FrameworkConfiguration config;
+  config[Constants::FRAMEWORK_EVENT_DELIVERY] = delivery;
+  config[Constants::FRAMEWORK_EVENT_QUEUE_LIMIT] = queueLimit;
+  auto f = FrameworkFactory().NewFramework(config);
+  f.Start();
+  return f;
+}
+
+void StopFramework(Framework& f)
+{
+  f.Stop();
+  f.WaitForStop(std::chrono::milliseconds::zero());
+}
+
+// Registers services with a slow listener attached and returns the time
+// the registrations took in milliseconds.
+long long RegisterServices(BundleContext context,
+                           SlowListener& listener,
+                           int numServices)
+{
+  context.AddServiceListener(std::ref(listener));
+  auto service = std::make_shared<EventPerfTestService>();
+
+  testing::HighPrecisionTimer timer;
+  timer.Start();
+  for (int i = 0; i < numServices; ++i) {
+    context.RegisterService<IEventPerfTestService>(service);
+  }
+  return timer.ElapsedMilli();
+}
+
+bool IsAscending(const std::vector<long>& ids)
+{
+  for (std::size_t i = 1; i < ids.size(); ++i) {
+    if (ids[i - 1] >= ids[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void TestSyncIsDefault()
+{
+  auto f = FrameworkFactory().NewFramework();
+  f.Start();
+  US_TEST_CONDITION(
+    any_cast<std::string>(f.GetBundleContext().GetProperty(
+      Constants::FRAMEWORK_EVENT_DELIVERY)) ==
+      Constants::FRAMEWORK_EVENT_DELIVERY_SYNC,
+    "Events are delivered synchronously by default");
+
+  SlowListener listener;
+  listener.delay = std::chrono::milliseconds::zero();
+  RegisterServices(f.GetBundleContext(), listener, 10);
+  US_TEST_CONDITION(listener.Count() == 10,
+                    "Listeners are called before RegisterService returns");
+  US_TEST_CONDITION(any_cast<long>(f.GetBundleContext().GetProperty(
+                      Constants::FRAMEWORK_EVENT_QUEUE_DEPTH)) == 0,
+                    "No events are queued");
+  StopFramework(f);
+}
+
+void TestAsyncDelivery()
+{
+  const int numServices = 100;
+
+  auto syncFramework = NewFramework(Constants::FRAMEWORK_EVENT_DELIVERY_SYNC);
+  SlowListener syncListener;
+  long long syncTime =
+    RegisterServices(syncFramework.GetBundleContext(), syncListener, numServices);
+  StopFramework(syncFramework);
+
+  auto f = NewFramework(Constants::FRAMEWORK_EVENT_DELIVERY_ASYNC);
+  auto context = f.GetBundleContext();
+  SlowListener listener;
+  long long asyncTime = RegisterServices(context, listener, numServices);
+
+  auto props = context.GetProperties();
+  US_TEST_CONDITION(props.count(Constants::FRAMEWORK_EVENT_QUEUE_DEPTH) == 1 &&
+                      props.count(Constants::FRAMEWORK_EVENT_QUEUE_MAX_DEPTH) ==
+                        1,
+                    "Event queue metrics are framework properties");
+  long maxDepth = any_cast<long>(
+    context.GetProperty(Constants::FRAMEWORK_EVENT_QUEUE_MAX_DEPTH));
+
+  // Wait for the queued events to be delivered
+  const auto deadline =
+    std::chrono::steady_clock::now() + std::chrono::seconds(30);
+  while (any_cast<long>(context.GetProperty(
+           Constants::FRAMEWORK_EVENT_QUEUE_DEPTH)) > 0 ||
+         listener.Count() < numServices) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      US_TEST_FAILED_MSG(<< "Timed out waiting for " << numServices
+                         << " events, " << listener.Count()
+                         << " were delivered")
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  US_TEST_OUTPUT(<< "Registering " << numServices << " services with a slow "
+                 << "listener took " << syncTime << " ms with synchronous and "
+                 << asyncTime << " ms with asynchronous event delivery, "
+                 << "max queue depth " << maxDepth);
+  US_TEST_CONDITION(asyncTime < syncTime,
+                    "A slow listener does not stall RegisterService");
+  US_TEST_CONDITION(maxDepth > 1, "Events were queued");
+  US_TEST_CONDITION(listener.Count() == numServices, "All events delivered");
+  US_TEST_CONDITION(IsAscending(listener.ids),
+                    "Events are delivered in the order they occurred");
+
+  StopFramework(f);
+}
+
+void TestBackpressure()
+{
+  const int queueLimit = 4;
+  auto f = NewFramework(Constants::FRAMEWORK_EVENT_DELIVERY_ASYNC, queueLimit);
+  auto context = f.GetBundleContext();
+
+  SlowListener listener;
+  RegisterServices(context, listener, 20);
+
+  long maxDepth = any_cast<long>(
+    context.GetProperty(Constants::FRAMEWORK_EVENT_QUEUE_MAX_DEPTH));
+  US_TEST_CONDITION(maxDepth <= queueLimit,
+                    "The queue limit blocks threads causing events");
+
+  StopFramework(f);
+  US_TEST_CONDITION(listener.Count() == 20,
+                    "Queued events are delivered before the framework stops");
+}
+
+void TestReleaseWithQueuedEvents()
+{
+  std::atomic<bool> stopped(false);
+  {
+    auto f = NewFramework(Constants::FRAMEWORK_EVENT_DELIVERY_ASYNC);
+    auto context = f.GetBundleContext();
+    context.AddBundleListener([&stopped](const BundleEvent& event) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      if (event.GetType() == BundleEvent::BUNDLE_STOPPED) {
+        stopped = true;
+      }
+    });
+    testing::InstallLib(context, "TestBundleA").Start();
+    // The framework is not stopped. The queued bundle events keep it
+    // alive, so the last reference is released by a delivery thread,
+    // which then shuts the framework down and destroys it.
+  }
+
+  const auto deadline =
+    std::chrono::steady_clock::now() + std::chrono::seconds(30);
+  while (!stopped) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      US_TEST_FAILED_MSG(<< "Timed out waiting for the framework to stop")
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  US_TEST_CONDITION(stopped,
+                    "A delivery thread releasing the framework stops it");
+}
+
+void TestRemovedBundleListener()
+{
+  auto f = NewFramework(Constants::FRAMEWORK_EVENT_DELIVERY_ASYNC);
+  auto context = f.GetBundleContext();
+
+  // Hold up the delivery of the first event, so that the following
+  // events stay queued.
+  std::atomic<bool> release(false);
+  context.AddBundleListener([&release](const BundleEvent&) {
+    const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (!release && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+
+  std::mutex mutex;
+  std::vector<std::string> received;
+  auto token = context.AddBundleListener([&](const BundleEvent& event) {
+    std::lock_guard<std::mutex> l(mutex);
+    received.push_back(event.GetBundle().GetSymbolicName());
+  });
+
+  testing::InstallLib(context, "TestBundleA");
+  testing::InstallLib(context, "TestBundleB");
+  context.RemoveListener(std::move(token));
+  release = true;
+  StopFramework(f);
+
+  US_TEST_CONDITION(
+    std::find(received.begin(), received.end(), "TestBundleB") ==
+      received.end(),
+    "Queued events are not delivered to removed bundle listeners");
+}
+
+void TestListenerException()
+{
+  auto f = NewFramework(Constants::FRAMEWORK_EVENT_DELIVERY_ASYNC);
+  auto context = f.GetBundleContext();
+
+  std::atomic<int> errors(0);
+  context.AddFrameworkListener([&errors](const FrameworkEvent& event) {
+    if (event.GetType() == FrameworkEvent::FRAMEWORK_ERROR) {
+      ++errors;
+    }
+  });
+  context.AddServiceListener(
+    [](const ServiceEvent&) { throw std::runtime_error("listener failed"); });
+  context.RegisterService<IEventPerfTestService>(
+    std::make_shared<EventPerfTestService>());
+
+  StopFramework(f);
+  US_TEST_CONDITION(errors == 1,
+                    "Listener exceptions are published as framework events");
+}
+}
+
+int EventDeliveryPerformanceTest(int /*argc*/, char* /*argv*/ [])
+{
+  US_TEST_BEGIN("EventDeliveryPerformanceTest");
+
+  TestSyncIsDefault();
+#ifdef US_ENABLE_THREADING_SUPPORT
+  TestAsyncDelivery();
+  TestBackpressure();
+  TestReleaseWithQueuedEvents();
+  TestRemovedBundleListener();
+  TestListenerException();
+#endif
+
+  US_TEST_END()
+}
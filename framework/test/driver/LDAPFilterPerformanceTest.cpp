@@ -0,0 +1,166 @@
+/*=============================================================================
+
+  Library: CppMicroServices
+
+  Copyright (c) The CppMicroServices developers. See the COPYRIGHT
+  file at the top-level directory of this distribution and at
+  https://github.com/CppMicroServices/CppMicroServices/COPYRIGHT .
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#include "cppmicroservices/AnyMap.h"
+#include "cppmicroservices/LDAPFilter.h"
+
+#include "TestUtils.h"
+#include "TestingMacros.h"
+
+#include <string>
+#include <vector>
+
+using namespace cppmicroservices;
+
+namespace {
+
+// The recursive wildcard matcher previously used by LDAPExpr. It is
+// kept here as a reference implementation for correctness and timing
+// comparisons.
+bool RecursivePatSubstr(const std::string& s,
+                        std::size_t si,
+                        const std::string& pat,
+                        std::size_t pi)
+{
+  if (pat.size() - pi == 0)
+    return s.size() - si == 0;
+  if (pat[pi] == '*') {
+    pi++;
+    for (;;) {
+      if (RecursivePatSubstr(s, si, pat, pi))
+        return true;
+      if (s.size() - si == 0)
+        return false;
+      si++;
+    }
+  } else {
+    if (s.size() - si == 0) {
+      return false;
+    }
+    if (s[si] != pat[pi]) {
+      return false;
+    }
+    return RecursivePatSubstr(s, ++si, pat, ++pi);
+  }
+}
+
+bool FilterMatch(const LDAPFilter& filter, const std::string& value)
+{
+  AnyMap props(AnyMap::UNORDERED_MAP_CASEINSENSITIVE_KEYS);
+  props["name"] = value;
+  return filter.Match(props);
+}
+
+void TestMatchesReference()
+{
+  const std::vector<std::string> patterns = {
+    "*",     "**",    "a",     "abc",     "a*",   "*c",
+    "*b*",   "a*c",   "a*b*c", "*a*b*",   "ab*ab", "*aab*",
+    "a**c",  "*a*",   "*aa*a", "*abab*a", "**a**b**"
+  };
+  const std::vector<std::string> values = {
+    "",     "a",      "b",     "c",     "ab",     "abc",   "abcabc",
+    "aab",  "aaab",   "abab",  "ababa", "ababab", "cba",   "aabab",
+    "acac", "bbbbbc", "aaaaa", "xabcx", "abbc",   "aabbcc"
+  };
+
+  std::size_t mismatches = 0;
+  for (const auto& pattern : patterns) {
+    LDAPFilter filter("(name=" + pattern + ")");
+    for (const auto& value : values) {
+      bool expected = RecursivePatSubstr(value, 0, pattern, 0);
+      if (FilterMatch(filter, value) != expected) {
+        US_TEST_OUTPUT(<< "Mismatch for " << value << " against " << pattern);
+        ++mismatches;
+      }
+    }
+  }
+  US_TEST_CONDITION(mismatches == 0,
+                    "Compiled matcher agrees with reference");
+}
+
+void TestBacktrackingPerformance()
+{
+  // A pattern with many wildcards which never matches forces the
+  // recursive matcher to try every split of the string.
+  const std::string pattern = "*a*a*a*b";
+  const std::string value(60, 'a');
+  const int iterations = 10;
+
+  testing::HighPrecisionTimer timer;
+  timer.Start();
+  bool recursiveResult = false;
+  for (int i = 0; i < iterations; ++i) {
+    recursiveResult |= RecursivePatSubstr(value, 0, pattern, 0);
+  }
+  long long recursiveTime = timer.ElapsedMicro();
+
+  LDAPFilter filter("(name=" + pattern + ")");
+  AnyMap props(AnyMap::UNORDERED_MAP_CASEINSENSITIVE_KEYS);
+  props["name"] = value;
+
+  timer.Start();
+  bool result = false;
+  for (int i = 0; i < iterations; ++i) {
+    result |= filter.Match(props);
+  }
+  long long time = timer.ElapsedMicro();
+
+  US_TEST_CONDITION(result == recursiveResult, "Same match result");
+  US_TEST_OUTPUT(<< "Matching " << pattern << " against " << value.size()
+                 << " characters " << iterations << " times: recursive "
+                 << recursiveTime << " us, compiled " << time << " us");
+}
+
+void TestLongStrings()
+{
+  // The recursive matcher needs one stack frame per character and
+  // would exhaust the stack here.
+  std::string value(1000000, 'x');
+  value.replace(value.size() / 2, 3, "abc");
+
+  const std::vector<std::string> patterns = { "xx*", "*xx", "*abc*",
+                                              "x*abc*x", "*a*b*c*" };
+  for (const auto& pattern : patterns) {
+    LDAPFilter filter("(name=" + pattern + ")");
+    testing::HighPrecisionTimer timer;
+    timer.Start();
+    US_TEST_CONDITION(FilterMatch(filter, value), "Match " << pattern);
+    US_TEST_OUTPUT(<< "Matching " << pattern << " against " << value.size()
+                   << " characters took " << timer.ElapsedMicro() << " us");
+  }
+
+  LDAPFilter noMatch("(name=*abd*)");
+  US_TEST_CONDITION(!FilterMatch(noMatch, value), "No match for *abd*");
+}
+}
+
+int LDAPFilterPerformanceTest(int /*argc*/, char* /*argv*/ [])
+{
+  US_TEST_BEGIN("LDAPFilterPerformanceTest");
+
+  TestMatchesReference();
+  TestBacktrackingPerformance();
+  TestLongStrings();
+
+  US_TEST_END()
+}
@@ -515,6 +515,85 @@ void frameSL25a(const Framework& framework)
   }
 }
 
+struct ServiceListenerTestA
+{
+  virtual ~ServiceListenerTestA() {}
+};
+
+struct ServiceListenerTestB
+{
+  virtual ~ServiceListenerTestB() {}
+};
+
+struct ServiceListenerTestImpl
+  : public ServiceListenerTestA
+  , public ServiceListenerTestB
+{};
+
+// Listeners with filters on the object class or the service id are
+// looked up in a cache instead of evaluating their filters.
+void frameSL30a(const Framework& framework)
+{
+  auto context = framework.GetBundleContext();
+  const std::string nameA = us_service_interface_iid<ServiceListenerTestA>();
+  const std::string nameB = us_service_interface_iid<ServiceListenerTestB>();
+
+  int countA = 0;
+  int countAorB = 0;
+  int countId = 0;
+  int countOther = 0;
+  auto tokenA = context.AddServiceListener(
+    [&countA](const ServiceEvent&) { ++countA; },
+    "(objectclass=" + nameA + ")");
+  auto tokenAorB = context.AddServiceListener(
+    [&countAorB](const ServiceEvent&) { ++countAorB; },
+    "(|(objectclass=" + nameA + ")(objectclass=" + nameB + "))");
+  auto tokenOther = context.AddServiceListener(
+    [&countOther](const ServiceEvent&) { ++countOther; },
+    "(objectclass=ServiceListenerTestUnknown)");
+
+  auto impl = std::make_shared<ServiceListenerTestImpl>();
+  auto regB = context.RegisterService<ServiceListenerTestB>(impl);
+  US_TEST_CONDITION(countA == 0, "No event for (objectclass=A)");
+  US_TEST_CONDITION(countAorB == 1,
+                    "Event for (|(objectclass=A)(objectclass=B))");
+
+  auto regA = context.RegisterService<ServiceListenerTestA>(impl);
+  regA.Unregister();
+  US_TEST_CONDITION(countA == 2, "Events for (objectclass=A)");
+  US_TEST_CONDITION(countAorB == 3,
+                    "Events for (|(objectclass=A)(objectclass=B))");
+
+  auto regAB =
+    context.RegisterService<ServiceListenerTestA, ServiceListenerTestB>(impl);
+  US_TEST_CONDITION(countA == 3, "Event for (objectclass=A)");
+  US_TEST_CONDITION(countAorB == 4, "One event for two matching classes");
+
+  auto id =
+    any_cast<long>(regAB.GetReference().GetProperty(Constants::SERVICE_ID));
+  auto tokenId = context.AddServiceListener(
+    [&countId](const ServiceEvent&) { ++countId; },
+    "(|(service.id=" + std::to_string(id) + ")(service.id=0" +
+      std::to_string(id) + "))");
+
+  context.RemoveListener(std::move(tokenA));
+  regAB.SetProperties(ServiceProperties());
+  US_TEST_CONDITION(countA == 3, "No event after removing listener");
+  US_TEST_CONDITION(countAorB == 5, "Event after removing another listener");
+  US_TEST_CONDITION(countId == 1, "Event for (service.id=" << id << ")");
+
+  regB.Unregister();
+  US_TEST_CONDITION(countId == 1, "No event for another service id");
+  regAB.Unregister();
+  US_TEST_CONDITION(countId == 2, "Event for (service.id=" << id << ")");
+  US_TEST_CONDITION(countAorB == 7, "Events for unregistration");
+  US_TEST_CONDITION(countOther == 0, "No event for an unknown class");
+
+  context.RemoveListener(std::move(tokenAorB));
+  context.RemoveListener(std::move(tokenOther));
+  context.RemoveListener(std::move(tokenId));
+}
+
 int ServiceListenerTest(int /*argc*/, char* /*argv*/ [])
 {
   US_TEST_BEGIN("ServiceListenerTest");
@@ -530,6 +609,7 @@ int ServiceListenerTest(int /*argc*/, char* /*argv*/ [])
   frameSL05a(framework);
   frameSL10a(framework);
   frameSL25a(framework);
+  frameSL30a(framework);
 
   US_TEST_END()
 }
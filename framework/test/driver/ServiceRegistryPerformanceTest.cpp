@@ -21,6 +21,7 @@
 =============================================================================*/
 
 #include "cppmicroservices/BundleContext.h"
+#include "cppmicroservices/Constants.h"
 #include "cppmicroservices/Framework.h"
 #include "cppmicroservices/FrameworkFactory.h"
 #include "cppmicroservices/GetBundleContext.h"
@@ -29,6 +30,9 @@
 #include "TestUtils.h"
 #include "TestingMacros.h"
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
 #include <vector>
 
 using namespace cppmicroservices;
@@ -71,6 +75,14 @@ public:
   void TestModifyServices();
   void TestUnregisterServices();
 
+  void TestConcurrentLookups();
+
+  void TestEventCostScaling();
+
+  void TestSortReferences();
+
+  void TestBundleServiceQueries();
+
 private:
   std::ostream& Log() const { return std::cout; }
 
@@ -78,6 +90,9 @@ private:
   void RegisterServices(int n);
   void ModifyServices();
   void UnregisterServices();
+  void ConcurrentLookups(int nReaders);
+  long long EventCost(int nNonMatchingListeners);
+  long long ServicesInUseCost();
 };
 
 class MyServiceListener
@@ -261,6 +276,234 @@ void ServiceRegistryPerformanceTest::UnregisterServices()
   regs.clear();
 }
 
+void ServiceRegistryPerformanceTest::TestConcurrentLookups()
+{
+  Log() << "Look up services from several reader threads while another "
+           "thread registers and unregisters services\n";
+
+  RegisterServices(nServices);
+
+  unsigned int maxReaders =
+    std::max(2u, std::min(8u, std::thread::hardware_concurrency()));
+  for (unsigned int nReaders = 1; nReaders <= maxReaders; nReaders *= 2) {
+    ConcurrentLookups(static_cast<int>(nReaders));
+  }
+
+  UnregisterServices();
+}
+
+void ServiceRegistryPerformanceTest::ConcurrentLookups(int nReaders)
+{
+#ifdef US_ENABLE_THREADING_SUPPORT
+  class PerfTestService : public IPerfTestService
+  {};
+
+  std::atomic<bool> stop(false);
+  std::atomic<std::size_t> lookups(0);
+  std::atomic<bool> failed(false);
+
+  std::thread writer([this, &stop]() {
+    auto service = std::make_shared<PerfTestService>();
+    while (!stop) {
+      ServiceProperties props;
+      props["perf.service.value"] = 0;
+      context.RegisterService<IPerfTestService>(service, props).Unregister();
+    }
+  });
+
+  std::vector<std::thread> readers;
+  for (int i = 0; i < nReaders; ++i) {
+    readers.emplace_back([this, &stop, &lookups, &failed]() {
+      std::size_t n = 0;
+      while (!stop) {
+        auto refs = context.GetServiceReferences<IPerfTestService>(
+          "(perf.service.value>=1)");
+        if (refs.size() != static_cast<std::size_t>(nServices)) {
+          failed = true;
+        }
+        ++n;
+      }
+      lookups += n;
+    });
+  }
+
+  testing::HighPrecisionTimer t;
+  t.Start();
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  stop = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  writer.join();
+  long long ms = t.ElapsedMilli();
+
+  Log() << nReaders << " reader thread(s): " << lookups << " lookups in "
+        << ms << "ms (" << (lookups * 1000 / (ms > 0 ? ms : 1))
+        << " lookups/s)\n";
+  US_TEST_CONDITION_REQUIRED(!failed,
+                             "Readers must see all registered services");
+#else
+  US_UNUSED(nReaders);
+#endif
+}
+
+void ServiceRegistryPerformanceTest::TestEventCostScaling()
+{
+  Log() << "Measure the cost of service events with a growing number of "
+           "listeners which do not match the events\n";
+
+  for (int n : { 0, 1000, 10000 }) {
+    long long us = EventCost(n);
+    Log() << n << " non-matching listeners: " << us
+          << "us per register/unregister cycle\n";
+  }
+}
+
+long long ServiceRegistryPerformanceTest::EventCost(int nNonMatchingListeners)
+{
+  class PerfTestService : public IPerfTestService
+  {};
+
+  std::vector<ListenerToken> tokens;
+  for (int i = 0; i < nNonMatchingListeners; ++i) {
+    tokens.push_back(context.AddServiceListener(
+      [](const ServiceEvent&) {},
+      "(objectclass=perf.test.NonMatching" + std::to_string(i) + ")"));
+  }
+
+  std::size_t nEvents = 0;
+  const std::string clazz = us_service_interface_iid<IPerfTestService>();
+  auto token = context.AddServiceListener(
+    [&nEvents](const ServiceEvent&) { ++nEvents; },
+    "(objectclass=" + clazz + ")");
+
+  const int cycles = 1000;
+  auto service = std::make_shared<PerfTestService>();
+  testing::HighPrecisionTimer t;
+  t.Start();
+  for (int i = 0; i < cycles; ++i) {
+    context.RegisterService<IPerfTestService>(service).Unregister();
+  }
+  long long us = t.ElapsedMicro();
+
+  context.RemoveListener(std::move(token));
+  for (auto& tok : tokens) {
+    context.RemoveListener(std::move(tok));
+  }
+
+  US_TEST_CONDITION_REQUIRED(nEvents == 2 * cycles,
+                             "Matching listener receives all events");
+  return us / cycles;
+}
+
+void ServiceRegistryPerformanceTest::TestSortReferences()
+{
+  class PerfTestService : public IPerfTestService
+  {};
+
+  const int n = 10000;
+  Log() << "Sort " << n << " service references\n";
+
+  auto service = std::make_shared<PerfTestService>();
+  std::vector<ServiceRegistration<IPerfTestService>> sortRegs;
+  for (int i = 0; i < n; ++i) {
+    ServiceProperties props;
+    props[Constants::SERVICE_RANKING] = i % 10;
+    sortRegs.push_back(
+      context.RegisterService<IPerfTestService>(service, props));
+  }
+
+  auto refs = context.GetServiceReferences<IPerfTestService>();
+  US_TEST_CONDITION_REQUIRED(refs.size() == static_cast<std::size_t>(n),
+                             "All services registered");
+
+  testing::HighPrecisionTimer t;
+  t.Start();
+  std::sort(refs.begin(), refs.end());
+  long long us = t.ElapsedMicro();
+  Log() << "sort took " << us << "us\n";
+
+  // The highest ranked service is the last one after sorting and
+  // changing its ranking must be visible to the next comparison.
+  ServiceReference<IPerfTestService> top = refs.back();
+  US_TEST_CONDITION(
+    any_cast<int>(top.GetProperty(Constants::SERVICE_RANKING)) == 9,
+    "Highest ranked reference sorts last");
+  US_TEST_CONDITION(context.GetServiceReference<IPerfTestService>() == top,
+                    "Highest ranked reference is returned");
+  for (auto& reg : sortRegs) {
+    if (reg.GetReference() == top) {
+      ServiceProperties props;
+      props[Constants::SERVICE_RANKING] = -1;
+      reg.SetProperties(props);
+    }
+  }
+  std::sort(refs.begin(), refs.end());
+  US_TEST_CONDITION(refs.front() == top, "Re-ranked reference sorts first");
+  US_TEST_CONDITION(!(context.GetServiceReference<IPerfTestService>() == top),
+                    "Re-ranked reference is no longer returned");
+
+  for (auto& reg : sortRegs) {
+    reg.Unregister();
+  }
+}
+
+void ServiceRegistryPerformanceTest::TestBundleServiceQueries()
+{
+  Log() << "Measure the cost of querying the services a bundle uses with "
+           "a growing number of other registered services\n";
+
+  long long emptyCost = ServicesInUseCost();
+  Log() << "0 other services: " << emptyCost << "us per query\n";
+
+  // Register the services under distinct class names so that the
+  // registrations themselves do not dominate the test time.
+  const int n = 10000;
+  auto service = std::make_shared<IPerfTestService>();
+  std::vector<ServiceRegistrationU> otherRegs;
+  for (int i = 0; i < n; ++i) {
+    auto interfaces = std::make_shared<InterfaceMap>();
+    (*interfaces)["perf.test.Other" + std::to_string(i)] = service;
+    otherRegs.push_back(context.RegisterService(interfaces));
+  }
+
+  long long cost = ServicesInUseCost();
+  Log() << n << " other services: " << cost << "us per query\n";
+
+  for (auto& reg : otherRegs) {
+    reg.Unregister();
+  }
+}
+
+long long ServiceRegistryPerformanceTest::ServicesInUseCost()
+{
+  class PerfTestService : public IPerfTestService
+  {};
+
+  auto reg = context.RegisterService<IPerfTestService>(
+    std::make_shared<PerfTestService>());
+  auto ref = reg.GetReference();
+  auto bundle = context.GetBundle();
+
+  auto service = context.GetService(ref);
+  US_TEST_CONDITION_REQUIRED(service, "Got service");
+
+  const int queries = 100;
+  std::size_t nInUse = 0;
+  testing::HighPrecisionTimer t;
+  t.Start();
+  for (int i = 0; i < queries; ++i) {
+    nInUse += bundle.GetServicesInUse().size();
+  }
+  long long us = t.ElapsedMicro();
+  US_TEST_CONDITION(nInUse == queries, "One service in use");
+
+  service.reset();
+  US_TEST_CONDITION(bundle.GetServicesInUse().empty(), "No service in use");
+  reg.Unregister();
+  return us / queries;
+}
+
 int ServiceRegistryPerformanceTest(int /*argc*/, char* /*argv*/ [])
 {
   US_TEST_BEGIN("ServiceRegistryPerformanceTest")
@@ -276,6 +519,10 @@ int ServiceRegistryPerformanceTest(int /*argc*/, char* /*argv*/ [])
   perfTest.TestModifyServices();
   perfTest.TestUnregisterServices();
   perfTest.CleanupTestCase();
+  perfTest.TestConcurrentLookups();
+  perfTest.TestEventCostScaling();
+  perfTest.TestSortReferences();
+  perfTest.TestBundleServiceQueries();
 
   US_TEST_END()
 }
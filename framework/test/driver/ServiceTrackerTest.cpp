@@ -36,6 +36,7 @@
 #include <future>
 #include <memory>
 #include <chrono>
+#include <thread>
 
 using namespace cppmicroservices;
 
@@ -0,0 +1,221 @@
+/*=============================================================================
+
+Library: CppMicroServices
+
+Copyright (c) The CppMicroServices developers. See the COPYRIGHT
+file at the top-level directory of this distribution and at
+https://github.com/CppMicroServices/CppMicroServices/COPYRIGHT .
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=============================================================================*/
+
+#include "cppmicroservices/ServiceInterface.h"
+
+#include "gtest/gtest.h"
+
+#include <map>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace cppmicroservices;
+
+namespace {
+
+struct InterfaceA
+{
+  virtual ~InterfaceA() {}
+};
+
+struct InterfaceB
+{
+  virtual ~InterfaceB() {}
+};
+
+struct ServiceAB
+  : public InterfaceA
+  , public InterfaceB
+{};
+
+std::vector<std::string> Keys(const InterfaceMap& map)
+{
+  std::vector<std::string> keys;
+  for (auto& entry : map) {
+    keys.push_back(entry.first);
+  }
+  return keys;
+}
+}
+
+TEST(InterfaceMapTest, SortedInsertion)
+{
+  InterfaceMap map;
+  ASSERT_TRUE(map.empty());
+
+  std::vector<std::string> expected;
+  for (auto key : { "d", "b", "f", "a", "c", "e", "g" }) {
+    auto value = std::make_shared<int>(static_cast<int>(expected.size()));
+    auto result = map.insert(std::make_pair(std::string(key), value));
+    ASSERT_TRUE(result.second);
+    ASSERT_EQ(result.first->first, key);
+    ASSERT_EQ(result.first->second, value);
+    expected.push_back(key);
+  }
+  std::sort(expected.begin(), expected.end());
+
+  // more entries than fit into the inline storage
+  const std::size_t inlineCapacity = InterfaceMap::INLINE_CAPACITY;
+  ASSERT_GT(map.size(), inlineCapacity);
+  ASSERT_EQ(Keys(map), expected);
+
+  auto existing = map.find("d");
+  auto result = map.insert(std::make_pair(std::string("d"), nullptr));
+  ASSERT_FALSE(result.second);
+  ASSERT_EQ(result.first, existing);
+  ASSERT_NE(existing->second, nullptr);
+
+  ASSERT_EQ(map.count("a"), 1u);
+  ASSERT_EQ(map.count("x"), 0u);
+  ASSERT_EQ(map.find("x"), map.end());
+  ASSERT_THROW(map.at("x"), std::out_of_range);
+
+  map["x"] = std::make_shared<int>(42);
+  ASSERT_EQ(*std::static_pointer_cast<int>(map.at("x")), 42);
+  ASSERT_EQ(Keys(map).back(), "x");
+}
+
+TEST(InterfaceMapTest, Erase)
+{
+  InterfaceMap map{ { "a", nullptr }, { "b", nullptr }, { "c", nullptr } };
+  ASSERT_EQ(map.erase("b"), 1u);
+  ASSERT_EQ(map.erase("b"), 0u);
+  ASSERT_EQ(Keys(map), std::vector<std::string>({ "a", "c" }));
+
+  auto iter = map.erase(map.begin());
+  ASSERT_EQ(iter->first, "c");
+  ASSERT_EQ(map.size(), 1u);
+
+  map.clear();
+  ASSERT_TRUE(map.empty());
+  ASSERT_EQ(map.begin(), map.end());
+}
+
+TEST(InterfaceMapTest, StdMapInterface)
+{
+  static_assert(
+    std::is_same<InterfaceMap::value_type,
+                 std::map<std::string, std::shared_ptr<void>>::value_type>::
+      value,
+    "InterfaceMap has the value_type of std::map");
+
+  InterfaceMap map;
+  ASSERT_TRUE(map.emplace("c", nullptr).second);
+  ASSERT_FALSE(map.emplace("c", nullptr).second);
+  map.emplace_hint(map.end(), "a", nullptr);
+  map.insert(map.begin(), std::make_pair(std::string("e"), nullptr));
+  std::vector<InterfaceMap::value_type> more{ { "b", nullptr },
+                                              { "d", nullptr } };
+  map.insert(more.begin(), more.end());
+  map.insert({ { "f", nullptr }, { "g", nullptr } });
+
+  std::vector<std::string> keys;
+  for (std::pair<const std::string, std::shared_ptr<void>>& entry : map) {
+    keys.push_back(entry.first);
+  }
+  ASSERT_EQ(keys,
+            std::vector<std::string>({ "a", "b", "c", "d", "e", "f", "g" }));
+
+  std::vector<std::string> reversed;
+  for (auto iter = map.crbegin(); iter != map.crend(); ++iter) {
+    reversed.push_back(iter->first);
+  }
+  ASSERT_TRUE(std::equal(keys.rbegin(), keys.rend(), reversed.begin()));
+
+  ASSERT_EQ(map.lower_bound("c")->first, "c");
+  ASSERT_EQ(map.upper_bound("c")->first, "d");
+  ASSERT_EQ(map.lower_bound("cc")->first, "d");
+  ASSERT_EQ(map.upper_bound("g"), map.end());
+  auto range = map.equal_range("e");
+  ASSERT_EQ(std::distance(range.first, range.second), 1);
+  ASSERT_TRUE(map.key_comp()("a", "b"));
+  ASSERT_TRUE(map.value_comp()(*map.begin(), *std::next(map.begin())));
+
+  auto iter = map.erase(map.find("b"), map.find("e"));
+  ASSERT_EQ(iter->first, "e");
+  ASSERT_EQ(Keys(map), std::vector<std::string>({ "a", "e", "f", "g" }));
+
+  // Entries keep their interface ids when moved by inserts and erases
+  auto idF = detail::GetInterfaceId("f");
+  ASSERT_EQ(map.find_id(idF)->first, "f");
+  map.erase(map.begin());
+  ASSERT_EQ(map.find_id(idF)->first, "f");
+
+  InterfaceMap smaller{ { "a", nullptr } };
+  ASSERT_LT(smaller, map);
+  ASSERT_GE(map, smaller);
+}
+
+TEST(InterfaceMapTest, CopyAndMove)
+{
+  for (std::size_t size : { 2, 8 }) {
+    InterfaceMap map;
+    for (std::size_t i = 0; i < size; ++i) {
+      map[std::to_string(i)] = std::make_shared<std::size_t>(i);
+    }
+
+    InterfaceMap copy(map);
+    ASSERT_EQ(copy, map);
+
+    InterfaceMap moved(std::move(copy));
+    ASSERT_EQ(moved, map);
+    ASSERT_TRUE(copy.empty());
+
+    copy = moved;
+    ASSERT_EQ(copy, map);
+    copy["extra"] = nullptr;
+    ASSERT_NE(copy, map);
+
+    moved = std::move(copy);
+    ASSERT_EQ(moved.size(), size + 1);
+    ASSERT_EQ(moved.count("extra"), 1u);
+  }
+}
+
+TEST(InterfaceMapTest, MakeInterfaceMap)
+{
+  auto service = std::make_shared<ServiceAB>();
+  InterfaceMapConstPtr map = MakeInterfaceMap<InterfaceA, InterfaceB>(service);
+  ASSERT_EQ(map->size(), 2u);
+
+  auto a = ExtractInterface<InterfaceA>(map);
+  auto b = ExtractInterface<InterfaceB>(map);
+  ASSERT_EQ(a.get(), static_cast<InterfaceA*>(service.get()));
+  ASSERT_EQ(b.get(), static_cast<InterfaceB*>(service.get()));
+  ASSERT_EQ(ExtractInterface(map, us_service_interface_iid<InterfaceB>()),
+            std::static_pointer_cast<void>(b));
+
+  auto iter = map->find_id(us_service_interface_id<InterfaceA>());
+  ASSERT_NE(iter, map->end());
+  ASSERT_EQ(iter->first, us_service_interface_iid<InterfaceA>());
+
+  // Entries inserted by name are found by id too
+  InterfaceMap byName;
+  byName[us_service_interface_iid<InterfaceB>()] = b;
+  ASSERT_EQ(ExtractInterface<InterfaceB>(
+              std::make_shared<const InterfaceMap>(byName)),
+            b);
+  ASSERT_EQ(ExtractInterface<InterfaceA>(
+              std::make_shared<const InterfaceMap>(byName)),
+            nullptr);
+}
@@ -88,3 +88,76 @@ TEST(LDAPFilter, DefaultConstructedMatch)
   ASSERT_NO_THROW(filter.Match(Bundle()));
   ASSERT_NO_THROW(filter.MatchCase(AnyMap(any_map::map_type::ORDERED_MAP)));
 }
+
+TEST(LDAPFilter, RepeatedFilterStrings)
+{
+  // Filters with the same string share a parsed expression, which
+  // must not leak state between independent filter objects.
+  AnyMap props(any_map::map_type::UNORDERED_MAP_CASEINSENSITIVE_KEYS);
+  props["name"] = std::string("foo");
+  for (int i = 0; i < 3; ++i) {
+    LDAPFilter filter("(name=f*)");
+    ASSERT_EQ(filter.ToString(), "(name=f*)");
+    ASSERT_TRUE(filter.Match(props));
+    ASSERT_FALSE(filter.MatchCase(AnyMap(any_map::map_type::ORDERED_MAP)));
+  }
+
+  // Invalid filters must throw every time and are never cached.
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_THROW(LDAPFilter("(name=foo"), std::invalid_argument);
+  }
+}
+
+TEST(LDAPFilter, TypedComparisons)
+{
+  AnyMap props(any_map::map_type::UNORDERED_MAP_CASEINSENSITIVE_KEYS);
+  props["int"] = 5;
+  props["ulong"] = 7ul;
+  props["double"] = 2.5;
+  props["float"] = 1.5f;
+  props["bool"] = true;
+  props["char"] = 'c';
+  props["list"] = std::vector<Any>{ Any(1), Any(std::string("two")) };
+
+  ASSERT_TRUE(LDAPFilter("(int=5)").Match(props));
+  ASSERT_TRUE(LDAPFilter("(int>=4)").Match(props));
+  ASSERT_FALSE(LDAPFilter("(int<=4)").Match(props));
+  ASSERT_FALSE(LDAPFilter("(int=five)").Match(props));
+  ASSERT_TRUE(LDAPFilter("(ulong<=7)").Match(props));
+  ASSERT_TRUE(LDAPFilter("(double>=2.25)").Match(props));
+  ASSERT_TRUE(LDAPFilter("(double~=2.5)").Match(props));
+  ASSERT_FALSE(LDAPFilter("(double=abc)").Match(props));
+  ASSERT_TRUE(LDAPFilter("(float=1.5)").Match(props));
+  ASSERT_TRUE(LDAPFilter("(bool=TRUE)").Match(props));
+  ASSERT_FALSE(LDAPFilter("(bool=false)").Match(props));
+  ASSERT_FALSE(LDAPFilter("(bool>=true)").Match(props));
+  ASSERT_FALSE(LDAPFilter("(bool=trueish)").Match(props));
+  ASSERT_TRUE(LDAPFilter("(char=c)").Match(props));
+  ASSERT_TRUE(LDAPFilter("(list=1)").Match(props));
+  ASSERT_TRUE(LDAPFilter("(list=t*o)").Match(props));
+  ASSERT_FALSE(LDAPFilter("(list=3)").Match(props));
+  ASSERT_TRUE(LDAPFilter("(int=*)").Match(props));
+}
+
+TEST(LDAPFilter, ManyProperties)
+{
+  // Exercise property lookups with enough keys to cause hash collisions.
+  AnyMap props(any_map::map_type::ORDERED_MAP);
+  for (int i = 0; i < 200; ++i) {
+    props["Key." + std::to_string(i)] = i;
+  }
+  props["objectclass"] = std::vector<std::string>{ "foo" };
+
+  for (int i = 0; i < 200; ++i) {
+    const std::string n = std::to_string(i);
+    ASSERT_TRUE(LDAPFilter("(key." + n + "=" + n + ")").Match(props));
+    ASSERT_TRUE(LDAPFilter("(KEY." + n + "=" + n + ")").Match(props));
+    ASSERT_TRUE(LDAPFilter("(Key." + n + "=" + n + ")").MatchCase(props));
+    ASSERT_FALSE(LDAPFilter("(key." + n + "=" + n + ")").MatchCase(props));
+  }
+  ASSERT_FALSE(LDAPFilter("(key.200=200)").Match(props));
+  ASSERT_TRUE(LDAPFilter("(ObjectClass=foo)").Match(props));
+
+  props["KEY.0"] = 1;
+  ASSERT_THROW(LDAPFilter("(key.0=0)").Match(props), std::runtime_error);
+}
@@ -24,6 +24,7 @@ limitations under the License.
 #include "cppmicroservices/Framework.h"
 #include "cppmicroservices/FrameworkEvent.h"
 #include "cppmicroservices/FrameworkFactory.h"
+#include "cppmicroservices/ServiceEvent.h"
 #include "cppmicroservices/ServiceObjects.h"
 #include "gtest/gtest.h"
 
@@ -42,8 +43,16 @@ struct ITestServiceB
   virtual int getValue() const = 0;
   virtual ~ITestServiceB() {}
 };
+
+struct ITestServiceAlias
+{
+  virtual ~ITestServiceAlias() {}
+};
 }
 
+CPPMICROSERVICES_DECLARE_SERVICE_INTERFACE(ServiceNS::ITestServiceAlias,
+                                           "ServiceNS::ITestServiceA")
+
 // This test exercises the 2 ways to register a service
 //   a. using the name of the interface i.e. "Foo::Bar"
 //   b. using the type of the interface i.e. <Foo::Bar>
@@ -104,4 +113,75 @@ TEST(ServiceReferenceTest, TestRegisterAndGetServiceReferenceTest)
 
   framework.Stop();
   framework.WaitForStop(std::chrono::milliseconds::zero());
-}
\ No newline at end of file
+}
+
+TEST(ServiceReferenceTest, TestInterfaceIds)
+{
+  auto idA = us_service_interface_id<ServiceNS::ITestServiceA>();
+  ASSERT_EQ(idA, us_service_interface_id<ServiceNS::ITestServiceA>());
+  ASSERT_NE(idA, us_service_interface_id<ServiceNS::ITestServiceB>());
+  // Types with the same interface id share the same integer id
+  ASSERT_EQ(idA, us_service_interface_id<ServiceNS::ITestServiceAlias>());
+
+  struct TestServiceB : public ServiceNS::ITestServiceB
+  {
+    int getValue() const { return 1729; }
+  };
+
+  FrameworkFactory factory;
+  auto framework = factory.NewFramework();
+  framework.Start();
+  auto context = framework.GetBundleContext();
+
+  ASSERT_FALSE(context.GetServiceReference("ServiceNS::ITestServiceUnknown"));
+
+  // Registering under a class name which was not interned before
+  InterfaceMap im;
+  im["ServiceNS::ITestServiceC"] = std::make_shared<TestServiceB>();
+  auto reg = context.RegisterService(std::make_shared<const InterfaceMap>(im));
+  auto ref = context.GetServiceReference("ServiceNS::ITestServiceC");
+  ASSERT_TRUE(ref);
+  ASSERT_EQ(ref, reg.GetReference());
+
+  reg.Unregister();
+  ASSERT_FALSE(context.GetServiceReference("ServiceNS::ITestServiceC"));
+
+  framework.Stop();
+  framework.WaitForStop(std::chrono::milliseconds::zero());
+}
+
+TEST(ServiceReferenceTest, TestListenerForUninternedClass)
+{
+  struct TestServiceB : public ServiceNS::ITestServiceB
+  {
+    int getValue() const { return 1729; }
+  };
+
+  FrameworkFactory factory;
+  auto framework = factory.NewFramework();
+  framework.Start();
+  auto context = framework.GetBundleContext();
+
+  // The filter names a class which has no interface id yet
+  int events = 0;
+  auto token = context.AddServiceListener(
+    [&events](const ServiceEvent&) { ++events; },
+    "(objectclass=ServiceNS::ITestServiceD)");
+
+  InterfaceMap im;
+  im["ServiceNS::ITestServiceD"] = std::make_shared<TestServiceB>();
+  auto reg = context.RegisterService(std::make_shared<const InterfaceMap>(im));
+  ASSERT_EQ(events, 1);
+
+  InterfaceMap other;
+  other["ServiceNS::ITestServiceE"] = std::make_shared<TestServiceB>();
+  context.RegisterService(std::make_shared<const InterfaceMap>(other));
+  ASSERT_EQ(events, 1);
+
+  context.RemoveListener(std::move(token));
+  reg.Unregister();
+  ASSERT_EQ(events, 1);
+
+  framework.Stop();
+  framework.WaitForStop(std::chrono::milliseconds::zero());
+}